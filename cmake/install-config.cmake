@@ -3,5 +3,6 @@
 
 include(CMakeFindDependencyMacro)
 find_dependency(Microsoft.GSL)
+find_dependency(Threads)
 
 include("${CMAKE_CURRENT_LIST_DIR}/Microsoft.IFCTargets.cmake")
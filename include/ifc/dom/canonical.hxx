@@ -0,0 +1,85 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Canonical form of the types of an IFC: equal types get equal ids.
+//
+// Several type records can denote the same type, e.g. two pointer types to the same
+// fundamental type, written in different places of the type partitions.  This pass gives
+// every type record a 128-bit structural hash, computed bottom-up from the hashes of its
+// component types, and a dense canonical id shared by the records of equal hash.  Once
+// built, comparing two types is comparing two integers.
+//
+// A type designated by a declaration is hashed by the qualified name of the declaration,
+// so the hashes of two IFCs can be compared with one another.  The exceptions are the
+// parts of types that are expressions or syntax trees, e.g. array bounds other than
+// literals, or the operands of decltype: they are hashed by their position in the IFC,
+// which makes types that differ only there distinct even when they are equal.
+
+#ifndef IFC_UTIL_CANONICAL_H
+#define IFC_UTIL_CANONICAL_H
+
+#include "ifc/reader.hxx"
+
+#include <array>
+#include <compare>
+#include <unordered_map>
+#include <vector>
+
+namespace ifc::util {
+    struct TypeHash {
+        uint64_t high = 0;
+        uint64_t low  = 0;
+
+        bool operator==(const TypeHash&) const  = default;
+        auto operator<=>(const TypeHash&) const = default;
+    };
+
+    struct TypeHashHasher {
+        std::size_t operator()(const TypeHash& h) const
+        {
+            return static_cast<std::size_t>(h.low);
+        }
+    };
+
+    class CanonicalTypes {
+    public:
+        // Hash all the type records of the reader's IFC.
+        explicit CanonicalTypes(Reader& reader);
+
+        // The structural hash of the type; the null type has a hash of its own.
+        TypeHash hash(TypeIndex index) const;
+
+        // The canonical id of the type, in [0, size()).
+        uint32_t id(TypeIndex index) const;
+
+        // This predicate holds if the two types are structurally equal.
+        bool same(TypeIndex a, TypeIndex b) const
+        {
+            return id(a) == id(b);
+        }
+
+        // Number of type records hashed, and number of distinct types among them.
+        std::size_t records() const
+        {
+            return record_count;
+        }
+
+        std::size_t size() const
+        {
+            return distinct.size();
+        }
+
+    private:
+        class Builder;
+
+        // Canonical id of each type record, by sort then position.
+        std::array<std::vector<uint32_t>, ifc::to_underlying(TypeSort::Count)> ids;
+        std::vector<TypeHash> distinct; // by canonical id
+        std::unordered_map<TypeHash, uint32_t, TypeHashHasher> by_hash;
+        std::size_t record_count = 0;
+
+        uint32_t intern(const TypeHash& h);
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_CANONICAL_H
@@ -0,0 +1,46 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Columnar export of the declaration and type partitions of an IFC, for bulk analytics.
+//
+// Each partition sort becomes one table (named after the partition, e.g. "decl.function")
+// with one row per partition entry, in partition order, so that the row number is the
+// index of the entry.  Columns carry the same information as the DOM properties of the
+// same name ("name", "type", "home-scope", "basic-specifiers", ...) and strings are
+// dictionary-encoded.  Rows are stored in chunks of at most chunk_rows rows, each chunk
+// with its own dictionaries.
+//
+// All integers are 32-bit little-endian, and every item is padded to a 4-byte boundary.
+//
+//   file   := magic version table-count table*
+//   table  := name:str row-count column-count (name:str type)* chunk-count chunk*
+//   chunk  := row-count column-data*            -- one per column, in column order
+//   U32    := value[row-count]
+//   String := entry-count offset[entry-count + 1] bytes pad code[row-count]
+//   str    := length bytes pad
+
+#ifndef IFC_UTIL_COLUMNAR_H
+#define IFC_UTIL_COLUMNAR_H
+
+#include "ifc/dom/node.hxx"
+
+#include <iosfwd>
+
+namespace ifc::util {
+    namespace columnar {
+        inline constexpr uint32_t magic      = 0x43434649; // "IFCC"
+        inline constexpr uint32_t version    = 1;
+        inline constexpr uint32_t chunk_rows = 1 << 16;
+
+        enum class ColumnType : uint32_t {
+            U32,
+            String,
+        };
+    } // namespace columnar
+
+    // Write the tables for the IFC to `out`.  Tables are built by `jobs` threads (by default,
+    // one per hardware thread), and written in a fixed order as soon as they are complete.
+    void write_columnar(Reader& reader, std::ostream& out, unsigned jobs = 0);
+} // namespace ifc::util
+
+#endif // IFC_UTIL_COLUMNAR_H
@@ -0,0 +1,82 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// A compact summary of the identifiers an IFC file holds, to pass over the files that cannot
+// declare a name without reading their string table.
+//
+// The filter of an IFC is a split-block Bloom filter of the strings of its string table
+// that are identifiers: each identifier sets one bit in each of the eight words of a block
+// of 256 bits chosen by its hash.  It answers whether an identifier may be among them; at
+// about 10 bits per identifier, it wrongly says so for 1 to 2% of the identifiers that are
+// not.  It cannot answer for a part of an identifier.
+//
+// The filters are kept in a cache file, by the content hash of the IFC in its header: a
+// file is then looked up after reading its header alone.
+
+#ifndef IFC_UTIL_FILTER_H
+#define IFC_UTIL_FILTER_H
+
+#include "ifc/file.hxx"
+
+#include <array>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace ifc::util {
+    class IdentifierFilter {
+    public:
+        // The filter of the identifiers among the NUL-terminated strings of a string table.
+        explicit IdentifierFilter(std::string_view strings);
+
+        // A filter as saved, see words().
+        explicit IdentifierFilter(std::vector<uint32_t> words);
+
+        // This predicate holds if the identifier may be in the string table.
+        bool may_contain(std::string_view identifier) const;
+
+        // The blocks of the filter, eight words each.
+        const std::vector<uint32_t>& words() const
+        {
+            return bits;
+        }
+
+    private:
+        std::vector<uint32_t> bits;
+    };
+
+    class FilterCache {
+    public:
+        // Read the cache saved in the file, if any.  A file that cannot be read, or was written by
+        // another version, leaves the cache empty.
+        explicit FilterCache(std::filesystem::path file);
+
+        // Whether the IFC of that content hash may have the identifier in its string table;
+        // nothing if its filter is not in the cache.  The cache can be used by several threads
+        // at once.
+        std::optional<bool> may_contain(const SHA256Hash& content_hash, std::string_view identifier) const;
+
+        void insert(const SHA256Hash& content_hash, IdentifierFilter filter);
+
+        // Write the filters looked up or inserted since the cache was read, if any was inserted:
+        // those of the files no longer looked at are dropped.  An exception is raised if the file
+        // cannot be written.
+        void save() const;
+
+    private:
+        struct Entry {
+            IdentifierFilter filter;
+            mutable bool used;
+        };
+
+        std::filesystem::path file;
+        mutable std::mutex mutex;
+        std::map<std::array<uint32_t, 8>, Entry> filters;
+        bool changed = false;
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_FILTER_H
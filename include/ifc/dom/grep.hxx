@@ -0,0 +1,102 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Search for declarations by name across many IFC files.
+//
+// Most files of a large tree do not declare what is looked for, so each file is first
+// looked at through its string table alone: the header and the string table are read,
+// without the partitions, and searched for the text that any match must contain.  Only
+// the files that pass are read whole, and the identities of their declarations checked
+// against the pattern.  The files are shared among several threads.  A cache of identifier
+// filters lets the search pass over most files after reading their header alone.
+
+#ifndef IFC_UTIL_GREP_H
+#define IFC_UTIL_GREP_H
+
+#include "ifc/dom/filter.hxx"
+#include "ifc/dom/modules.hxx"
+
+#include <filesystem>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ifc::util {
+    // A pattern over the qualified names of declarations, e.g. "foo::Widget".
+    //
+    // A plain pattern matches the names equal to it or ending with "::" followed by it, so
+    // that "Widget" and "foo::Widget" both find "ns::foo::Widget"; a leading "::" anchors it
+    // at the global scope.  A regular pattern (ECMAScript syntax) matches the names it is
+    // found in.
+    class SymbolPattern {
+    public:
+        // An exception is raised if a regular pattern is malformed.
+        SymbolPattern(std::string_view pattern, bool regular);
+
+        // This predicate holds if a file with that string table may declare a matching name.
+        bool may_occur(std::string_view strings) const;
+
+        bool matches(std::string_view qualified_name) const;
+
+        // The text every matching name has as one of its components, or part of one; empty if
+        // there is none, in which case no file is passed over.
+        const std::string& required() const
+        {
+            return needle;
+        }
+
+        // This predicate holds if the pattern is plain, with an identifier as last component:
+        // the last component of a match is then exactly required().
+        bool exact() const
+        {
+            return not regular and not needle.empty();
+        }
+
+    private:
+        std::string text;
+        bool regular;
+        std::optional<std::regex> expression;
+        std::string needle;
+    };
+
+    struct SymbolMatch {
+        std::string name;     // qualified name
+        const char* kind;     // sort of the declaration, e.g. "decl.function"
+        std::string location; // "file:line:column", or "?" if the IFC does not say
+    };
+
+    struct FileMatches {
+        std::filesystem::path path;
+        ModuleName module;
+        std::vector<SymbolMatch> matches; // in the order of the declaration partitions
+        bool failed = false;              // the file is an IFC that could not be read
+    };
+
+    struct DeclaredName {
+        DeclIndex decl;
+        std::string name;       // qualified name
+        std::string identifier; // last component of the name
+    };
+
+    // The declarations of the IFC that are members of scopes, with their names, in the order of
+    // the declaration partitions.  These are the declarations a search looks at.
+    std::vector<DeclaredName> declared_names(Reader& reader);
+
+    // The declarations of the IFC file that match the pattern.  Nothing is found in a file
+    // that is not an IFC, and a damaged IFC is marked as failed: no exception is raised.  With
+    // a cache of identifier filters (see filter.hxx), a file whose filter rules out the last
+    // component of a plain pattern is passed over after reading its header; the filter of a
+    // file not in the cache is added to it.
+    FileMatches grep_ifc(const std::filesystem::path& path, const SymbolPattern& pattern,
+                         FilterCache* cache = nullptr);
+
+    // Same as above for each of the files, shared among `jobs` threads (by default, one per
+    // hardware thread).  Only the files with matches, or that failed, are kept, in the order
+    // of `paths`.
+    std::vector<FileMatches> grep_ifcs(const std::vector<std::filesystem::path>& paths, const SymbolPattern& pattern,
+                                       unsigned jobs = 0, FilterCache* cache = nullptr);
+} // namespace ifc::util
+
+#endif // IFC_UTIL_GREP_H
@@ -0,0 +1,75 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// The interface an IFC presents to its importers, as a set of entities that can be
+// compared across two builds of the same module.
+//
+// The entities are the declarations found in the global scope and, recursively, in
+// the namespaces; namespaces themselves are only containers.  An entity is identified
+// by its qualified name, and has a structural hash: a hash of the DOM nodes of the
+// declaration and of everything they refer to, except for source locations and for the
+// positions of the nodes in their partitions.  A reference to a declaration counts as
+// its qualified name, and any other reference as the structural hash of its target.
+//
+// The semantic hash of an IFC is that of its unit and of its exported entities.  It stays
+// the same when only source locations change, and it does not cover the partitions that
+// importers do not look at: line tables, debug records and code analysis partitions.
+
+#ifndef IFC_UTIL_INTERFACE_H
+#define IFC_UTIL_INTERFACE_H
+
+#include "ifc/dom/node.hxx"
+#include "ifc/reader.hxx"
+
+#include <string>
+#include <vector>
+
+namespace ifc::util {
+    struct Entity {
+        std::string name;  // qualified name; for overloads, followed by the type in brackets
+        const char* kind;  // sort of the declaration, e.g. "decl.function"
+        uint64_t hash;     // structural hash
+        DeclIndex decl;    // the declaration, in its IFC
+        std::string scope; // qualified name of the enclosing namespace, empty for the global scope
+    };
+
+    // The entities of the IFC, sorted by name.  Declarations that are not exported are left
+    // out unless `all` is set.  Top-level declarations are shared among `jobs` threads
+    // (by default, one per hardware thread).
+    std::vector<Entity> interface_entities(const InputIfc& ifc, bool all = false, unsigned jobs = 0);
+
+    // Same as above, through a reader of the IFC.
+    std::vector<Entity> interface_entities(Reader& reader, bool all = false, unsigned jobs = 0);
+
+    // This predicate holds if the two IFCs have the same string table, and the same partitions
+    // under the same names, byte for byte, wherever they are in the files.
+    bool same_partitions(const InputIfc& a, const InputIfc& b);
+
+    enum class Change : uint8_t {
+        Added,
+        Removed,
+        Changed,
+    };
+
+    struct EntityChange {
+        Change change;
+        std::string name;
+        const char* kind;
+    };
+
+    // The semantic hash of the IFC: SHA-256 of its unit, then of the name, kind and structural
+    // hash of each of its exported entities, in the order of interface_entities().
+    SHA256Hash semantic_hash(const InputIfc& ifc, unsigned jobs = 0);
+
+    // Same as above, for entities already computed by interface_entities(ifc).
+    SHA256Hash semantic_hash(const InputIfc& ifc, const std::vector<Entity>& entities);
+
+    // The entities added, removed or changed from `before` to `after`, sorted by name.
+    std::vector<EntityChange> diff_interfaces(const InputIfc& before, const InputIfc& after, bool all = false,
+                                              unsigned jobs = 0);
+
+    // Same as above, for entities already computed by interface_entities().
+    std::vector<EntityChange> diff_entities(const std::vector<Entity>& before, const std::vector<Entity>& after);
+} // namespace ifc::util
+
+#endif // IFC_UTIL_INTERFACE_H
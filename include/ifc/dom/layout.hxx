@@ -0,0 +1,80 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Precomputed icicle layout of the declaration tree of an IFC, in the binary form loaded
+// by the sgraph-js viewer (samples/sgraph-js/ui/layout.js).
+//
+// The tree is the one the viewer draws: the global scope, with the declarations in each
+// scope as children of the declaration of the scope.  A node is sized by the number of
+// leaves below it, children are ordered by decreasing size, and each depth is one row.
+// Coordinates are normalized to [0, 1], so the viewer only scales them to its canvas.
+//
+// Layout: a Header, followed by the tiles, the nodes, the edges and the label bytes.
+// Nodes are stored row by row, left to right, and each row is cut into tiles of at most
+// tile_nodes nodes.  A tile records the horizontal extent of its nodes, which lets the
+// viewer skip the tiles out of view.  Edges are the references between declarations of
+// the tree.  All integers are little-endian and all records are 4-byte aligned.
+
+#ifndef IFC_UTIL_LAYOUT_H
+#define IFC_UTIL_LAYOUT_H
+
+#include "ifc/dom/node.hxx"
+
+#include <cstddef>
+#include <vector>
+
+namespace ifc::util {
+    namespace layout {
+        inline constexpr uint32_t magic      = 0x4C434649; // "IFCL"
+        inline constexpr uint32_t version    = 1;
+        inline constexpr uint32_t tile_nodes = 4096;
+        inline constexpr uint32_t no_parent  = 0xFFFFFFFF;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t tile_count;
+            uint32_t node_count;
+            uint32_t edge_count;
+            uint32_t depth_count;
+            uint32_t label_bytes;
+        };
+
+        struct Tile {
+            uint32_t depth;
+            uint32_t first_node;
+            uint32_t node_count;
+            float x0; // extent of the nodes of the tile
+            float x1;
+        };
+
+        struct NodeRecord {
+            float x0;
+            float y0;
+            float x1;
+            float y1;
+            uint32_t parent; // position of the parent node, or no_parent for the root
+            uint32_t value;  // number of leaves in the subtree
+            uint32_t label_offset;
+            uint32_t label_length;
+            SortKind kind; // key of the DOM node
+            uint16_t sort;
+            uint32_t index;
+        };
+
+        struct Edge {
+            uint32_t from; // positions of the nodes
+            uint32_t to;
+        };
+
+        static_assert(sizeof(Header) == 28);
+        static_assert(sizeof(Tile) == 20);
+        static_assert(sizeof(NodeRecord) == 40);
+        static_assert(sizeof(Edge) == 8);
+    } // namespace layout
+
+    // Lay out the tree of declarations rooted at the node, usually the global scope.
+    std::vector<std::byte> write_layout(const Node& root);
+} // namespace ifc::util
+
+#endif // IFC_UTIL_LAYOUT_H
@@ -0,0 +1,99 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// One view of the entities of several IFCs, e.g. of the header units of a program.
+//
+// Header units carry their own copies of the global module entities they include, so the
+// same declaration of `std::size_t` can be found in each of them.  The merged view holds
+// one entity for all the declarations with the same qualified name, kind and structural
+// hash (see interface.hxx) that belong to the global module, or to the same named module,
+// and lists where each of them comes from.  Declarations of the same name that differ
+// stay apart, next to one another.
+//
+// The entities are arranged in a tree of namespaces, with the global scope at its root.
+
+#ifndef IFC_UTIL_MERGED_H
+#define IFC_UTIL_MERGED_H
+
+#include "ifc/dom/interface.hxx"
+
+#include <string_view>
+#include <vector>
+
+namespace ifc::util {
+    // A declaration of a merged entity in one of the IFCs.
+    struct Provenance {
+        uint32_t file; // position of the reader among those merged
+        DeclIndex decl;
+    };
+
+    struct MergedEntity {
+        std::string name; // qualified name, as in Entity
+        const char* kind;
+        uint64_t hash;
+        std::string_view owner;          // module name, empty for the global module
+        std::vector<Provenance> sources; // by file
+    };
+
+    struct MergedScope {
+        std::string name;              // qualified name, empty for the global scope
+        std::vector<uint32_t> scopes;  // nested namespaces, by name
+        std::vector<uint32_t> members; // entities, by name
+    };
+
+    class MergedReader {
+    public:
+        // Merge the entities of the readers, which must outlive the merged view.  The arguments
+        // `all` and `jobs` are those of interface_entities(); the files are read one after
+        // the other.
+        explicit MergedReader(std::vector<Reader*> readers, bool all = false, unsigned jobs = 0);
+
+        std::size_t files() const
+        {
+            return readers.size();
+        }
+
+        Reader& reader(uint32_t file) const
+        {
+            return *readers[file];
+        }
+
+        // The merged entities, sorted by name.
+        const std::vector<MergedEntity>& entities() const
+        {
+            return merged;
+        }
+
+        const MergedEntity& entity(uint32_t index) const
+        {
+            return merged[index];
+        }
+
+        const MergedScope& global() const
+        {
+            return scopes.front();
+        }
+
+        const MergedScope& scope(uint32_t index) const
+        {
+            return scopes[index];
+        }
+
+        // The entities of that name, or an empty range if none.
+        gsl::span<const MergedEntity> find(std::string_view name) const;
+
+        // Number of declarations merged, i.e. the sum of the sources of all entities.
+        std::size_t declarations() const
+        {
+            return declaration_count;
+        }
+
+    private:
+        std::vector<Reader*> readers;
+        std::vector<MergedEntity> merged;
+        std::vector<MergedScope> scopes;
+        std::size_t declaration_count = 0;
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_MERGED_H
@@ -0,0 +1,136 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// The closure of an IFC under the modules it imports.
+//
+// An IFC names the modules it imports, and those it re-exports, in the "module.imported"
+// and "module.exported" partitions.  A ModuleSet starts from one IFC, finds the files of
+// those modules with a resolver, and loads them, then the modules they name, and so on.
+// Each round of files is read in parallel.  The result is the graph of dependencies among
+// the loaded modules, with one Reader per file; a cycle in it is an error.
+
+#ifndef IFC_UTIL_MODULES_H
+#define IFC_UTIL_MODULES_H
+
+#include "ifc/reader.hxx"
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ifc::util {
+    // A reference to a module, a module partition or a header unit.
+    struct ModuleName {
+        std::string owner;     // module name; empty for a header unit
+        std::string partition; // partition name, if any; for a header unit, path of the header
+
+        bool header_unit() const
+        {
+            return owner.empty();
+        }
+
+        bool operator==(const ModuleName&) const  = default;
+        auto operator<=>(const ModuleName&) const = default;
+    };
+
+    // "M", "M:P", or the path of the header.
+    std::string to_string(const ModuleName& name);
+
+    // The name of the unit of the IFC.  The name of a translation unit that is neither a
+    // module nor a header unit is empty.
+    ModuleName unit_name(const InputIfc& ifc);
+
+    // Same as above, from the unit sort and the name recorded in the header.
+    ModuleName unit_name(UnitSort sort, std::string name);
+
+    // The modules imported and exported by the IFC, without repetitions.
+    std::vector<ModuleName> module_dependencies(const Reader& reader);
+
+    // Find the file of a module, if any.
+    using ModuleResolver = std::function<std::optional<std::filesystem::path>(const ModuleName&)>;
+
+    // Look for the files in a list of directories, in order.  The file of module M is M.ifc, that
+    // of partition M:P is M-P.ifc, and that of a header unit is the name of the header followed
+    // by .ifc, e.g. vector.ifc; the latter is also looked for next to the header.
+    ModuleResolver search_path_resolver(std::vector<std::filesystem::path> directories);
+
+    // Exception tag used to signal modules that import one another.
+    struct ModuleCycle {
+        std::vector<std::string> names; // along the cycle, the first one repeated at the end
+    };
+
+    struct Module;
+
+    // Read the IFC file, of any unit sort, and check its integrity.  The name of the module is
+    // that of its unit; it has no dependencies yet.
+    std::unique_ptr<Module> load_module(const std::filesystem::path& path);
+
+    struct Module {
+        std::filesystem::path path;
+        ModuleName name;
+        std::vector<uint32_t> dependencies; // positions in the set
+        std::vector<ModuleName> unresolved; // dependencies the resolver did not find
+
+        const InputIfc& ifc() const
+        {
+            return file;
+        }
+
+        Reader& reader() const
+        {
+            return *file_reader;
+        }
+
+    private:
+        friend std::unique_ptr<Module> load_module(const std::filesystem::path&);
+        std::vector<std::byte> contents;
+        InputIfc file;
+        std::unique_ptr<Reader> file_reader;
+    };
+
+    class ModuleSet {
+    public:
+        // Load `root` and the modules it depends on, directly or not.  A file depended on through
+        // several names, or paths, is loaded once.  Each round of loads is shared among `jobs`
+        // threads (by default, one per hardware thread).
+        ModuleSet(const std::filesystem::path& root, ModuleResolver resolver, unsigned jobs = 0);
+
+        std::size_t size() const
+        {
+            return modules.size();
+        }
+
+        // The root is at position 0.
+        const Module& root() const
+        {
+            return *modules.front();
+        }
+
+        const Module& operator[](uint32_t index) const
+        {
+            return *modules[index];
+        }
+
+        // The position of the module of that name, if loaded.
+        std::optional<uint32_t> find(const ModuleName& name) const;
+
+        // The positions of the modules, each after those it depends on.
+        const std::vector<uint32_t>& dependency_order() const
+        {
+            return order;
+        }
+
+    private:
+        std::vector<std::unique_ptr<Module>> modules;
+        std::map<ModuleName, uint32_t> by_name;
+        std::vector<uint32_t> order;
+
+        void sort_dependencies();
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_MODULES_H
@@ -21,10 +21,14 @@
 #include "ifc/reader.hxx"
 #include "ifc/util.hxx"
 
+#include <algorithm>
 #include <compare>
 #include <iosfwd>
 #include <map>
 #include <set>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <stdexcept>
@@ -97,6 +101,10 @@ namespace ifc::util {
         NodeKey(T value) : index_kind(sort_kind(value)), index_sort(), index_value(ifc::to_underlying(value))
         {}
 
+        // reconstruct a key from its parts, e.g. when reading a snapshot.
+        NodeKey(SortKind kind, uint16_t sort, uint32_t value) : index_kind(kind), index_sort(sort), index_value(value)
+        {}
+
         bool operator==(const NodeKey&) const  = default;
         auto operator<=>(const NodeKey&) const = default;
 
@@ -110,6 +118,12 @@ namespace ifc::util {
             return index_value;
         }
 
+        // Underlying value of the sort of the abstract index, zero for unisorted indices.
+        auto sort() const
+        {
+            return index_sort;
+        }
+
         // convert back to abstract indices
         template<typename F>
         decltype(auto) visit(F&& f);
@@ -140,6 +154,12 @@ namespace ifc::util {
         // clang-format on
     }
 
+    // Write the abstract index designated by the key, e.g. "decl.function-3"; see util::format_to.
+    inline char* format_to(char* buf, NodeKey key)
+    {
+        return key.visit([buf](auto index) { return format_to(buf, index); });
+    }
+
     struct Node;
 
     using PropertyMap = std::map<std::string, std::string>;
@@ -155,20 +175,106 @@ namespace ifc::util {
 
         PropertyMap props;
         Nodes children;
+
+        // Nodes referred to by a string in id or props rather than by a child edge.
+        std::vector<NodeKey> references;
+    };
+
+    // Memo table for the short strings rendered for abstract indices, see short_string().
+    // Renderings are interned, so equal strings share storage, and they are produced
+    // in a single reusable buffer: a nested rendering is appended past the current
+    // end of the buffer and the buffer is truncated back once it has been interned.
+    // The node references made by a rendering are kept with it, so that they can be
+    // recorded again each time the memoized string is used.
+    class RenderCache {
+        struct Hash {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const
+            {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        struct Entry {
+            std::string_view text;
+            uint32_t first_reference;
+            uint32_t reference_count;
+        };
+
+        std::unordered_map<uint64_t, Entry> memo;
+        std::unordered_set<std::string, Hash, std::equal_to<>> interned;
+        std::vector<NodeKey> references;
+        std::string buffer;
+
+        std::string_view intern(std::string_view str)
+        {
+            if (auto it = interned.find(str); it != interned.end())
+                return *it;
+            return *interned.emplace(str).first;
+        }
+
+    public:
+        // Return the memoized string for the index, calling `render(buffer)` to append it on first use.
+        // The references made by the rendering are those appended to `log` meanwhile; on later uses,
+        // `replay` is called on each of them.
+        template<index_like::MultiSorted Key, typename F, typename R>
+        std::string_view get(Key index, F&& render, const std::vector<NodeKey>& log, R&& replay)
+        {
+            const auto key = uint64_t{ifc::to_underlying(sort_kind(index))} << 32
+                             | ifc::to_underlying(index_like::rep(index));
+            if (auto it = memo.find(key); it != memo.end())
+            {
+                const auto entry = it->second;
+                for (auto i = entry.first_reference; i < entry.first_reference + entry.reference_count; ++i)
+                    replay(NodeKey{references[i]});
+                return entry.text;
+            }
+
+            const auto mark     = buffer.size();
+            const auto log_mark = log.size();
+            std::forward<F>(render)(buffer);
+            const auto result = intern(std::string_view{buffer}.substr(mark));
+            buffer.resize(mark);
+
+            const auto first = static_cast<uint32_t>(references.size());
+            for (auto i = log_mark; i < log.size(); ++i)
+                references.push_back(log[i]);
+            memo.emplace(key, Entry{result, first, static_cast<uint32_t>(references.size() - first)});
+            return result;
+        }
     };
 
+    class Snapshot;
+
     // Enumerators and parameters are represented in their sequences by
     // value, not by index, thus, the getter need to be aware of that.
     template<typename T>
     concept EnumeratorOrParameterDecl =
         std::same_as<T, symbolic::EnumeratorDecl> or std::same_as<T, symbolic::ParameterDecl>;
 
+    // Order in which the Loader populates pending nodes.
+    enum class LoadOrder : uint8_t {
+        DepthFirst, // most recently requested node first
+        Address,    // pending nodes in batches, each in ascending file offset (partition, then position)
+    };
+
     // Loader is responsible for loading the nodes and resolving references.
     // It is also hosts the storage for all the nodes.
+    //
+    // Nodes are populated from an explicit work list rather than by native recursion,
+    // so the depth of an expression or initializer tree is bounded only by the heap.
+    // A node returned by get() while another node is being loaded (e.g. a child being
+    // attached by a loader visitor) is populated by the time the outermost get() returns.
+    //
+    // The load order does not affect the resulting nodes, nor referenced_nodes once get()
+    // returns; LoadOrder::Address trades the depth-first walk, which hops between the
+    // decl, type, expr and heap partitions on nearly every step, for mostly forward scans
+    // over each partition.  It is intended for passes that load a whole module.
     struct Loader {
         ifc::Reader& reader;
 
-        explicit Loader(Reader& reader_) : reader(reader_) {}
+        explicit Loader(Reader& reader_, LoadOrder order_ = LoadOrder::DepthFirst) : reader(reader_), order(order_)
+        {}
 
         template<index_like::Algebra Key>
         const Node& get(Key abstract_index);
@@ -183,11 +289,69 @@ namespace ifc::util {
         std::string ref(const symbolic::Identity<TextOffset>& id);
         std::string ref(const symbolic::Identity<NameIndex>& id);
 
+        // Same as ref(index), except that the string is appended to `out`.
+        template<index_like::MultiSorted T>
+        void append_ref(std::string& out, T index);
+
+        // Note that the node being loaded refers to the node with that key. Unless the latter
+        // is loaded, it is added to referenced_nodes.
+        void reference(NodeKey key);
+
+        // Return the short string for the index, rendered by `render(std::string&)` on first use.
+        template<index_like::MultiSorted Key, typename F>
+        std::string_view render(Key index, F&& f);
+
+        // Populate the nodes found in the snapshot from it rather than from the IFC; see snapshot.hxx.
+        // The snapshot must outlive the loader.
+        void attach(const Snapshot& snapshot);
+
         std::set<NodeKey> referenced_nodes;
 
+        // Short strings for types and expressions, memoized for the lifetime of the loader.
+        RenderCache rendered;
+
     private:
+        // Continuation record for a node that was created but not populated yet.
+        // The abstract index is kept in its representational form along with the
+        // loader instantiated for its original type.
+        struct PendingLoad {
+            Node* node;
+            index_like::Index index;
+            void (*load)(Loader&, Node&, index_like::Index);
+            ByteOffset offset; // Location of the record, for LoadOrder::Address.
+        };
+
+        template<index_like::Algebra Key>
+        static void load_pending(Loader& ctx, Node& node, index_like::Index index);
+
+        // Queue the node to be populated from the attached snapshot, if the snapshot has it.
+        bool queue_restore(Node& node);
+        static void restore_pending(Loader& ctx, Node& node, index_like::Index record);
+        Node& enqueue(NodeKey key);
+
+        // Byte offset of the record designated by the index, or zero if there is none.
+        template<index_like::Algebra Key>
+        ByteOffset locate(Key abstract_index) const;
+
+        template<index_like::Algebra Key>
+        Node& enqueue(Key abstract_index);
+        void drain();
+
         using NodeMap = std::map<NodeKey, Node>;
         NodeMap all_nodes;
+        std::vector<PendingLoad> pending;
+        std::vector<PendingLoad> batch;
+        LoadOrder order;
+        bool draining = false;
+
+        // The node being populated, which reference() attributes references to.
+        Node* current = nullptr;
+        // References made while no node is being populated.
+        std::vector<NodeKey> unattributed;
+
+        const Snapshot* snapshot = nullptr;
+
+        friend std::vector<std::byte> write_snapshot(const Loader&);
     };
 
     // implementation details
@@ -214,35 +378,179 @@ namespace ifc::util {
         return "";
     }
 
+    // Memoized versions of the above; the strings are owned by the Loader.
+    std::string_view short_string(Loader&, TypeIndex);
+    std::string_view short_string(Loader&, ExprIndex);
+
+    template<index_like::MultiSorted Index>
+    std::string_view short_string(Loader&, Index)
+    {
+        return {};
+    }
+
     template<index_like::MultiSorted T>
     std::string Loader::ref(T index)
+    {
+        std::string result;
+        append_ref(result, index);
+        return result;
+    }
+
+    template<index_like::MultiSorted T>
+    void Loader::append_ref(std::string& out, T index)
     {
         if (null(index))
-            return "no-" + to_string(sort_kind(index));
+        {
+            out.append("no-").append(to_string(sort_kind(index)));
+            return;
+        }
 
-        if (auto str = get_string_if_possible(*this, index); not str.empty())
-            return str;
+        if (auto str = short_string(*this, index); not str.empty())
+        {
+            out.append(str);
+            return;
+        }
+
+        reference(index);
+        append_to(out, index);
+    }
+
+    inline void Loader::reference(NodeKey key)
+    {
+        (current != nullptr ? current->references : unattributed).push_back(key);
+        if (not all_nodes.contains(key))
+            referenced_nodes.insert(key);
+    }
 
-        if (not all_nodes.contains(index))
-            referenced_nodes.insert(index);
+    template<index_like::MultiSorted Key, typename F>
+    std::string_view Loader::render(Key index, F&& f)
+    {
+        const auto& log = current != nullptr ? current->references : unattributed;
+        return rendered.get(index, std::forward<F>(f), log, [this](NodeKey key) { reference(key); });
+    }
 
-        return to_string(index);
+    template<index_like::Algebra Key>
+    void Loader::load_pending(Loader& ctx, Node& node, index_like::Index index)
+    {
+        load(ctx, node, index_like::per<Key>(index));
     }
 
     template<index_like::Algebra Key>
-    const Node& Loader::get(Key abstract_index)
+    ByteOffset Loader::locate(Key abstract_index) const
+    {
+        const auto& toc = reader.table_of_contents();
+        if (index_like::null(abstract_index))
+            return {};
+
+        if constexpr (std::same_as<Key, ScopeIndex>)
+        {
+            const auto position = ifc::to_underlying(abstract_index) - 1;
+            return toc.scopes.offset + position * ifc::to_underlying(toc.scopes.entry_size);
+        }
+        else if constexpr (index_like::MultiSorted<Key>)
+        {
+            // Leave malformed indices to the loader to diagnose.
+            using Sort = decltype(abstract_index.sort());
+            if (abstract_index.sort() >= Sort::Count)
+                return {};
+            if constexpr (std::same_as<Key, NameIndex>)
+            {
+                if (abstract_index.sort() == NameSort::Identifier)
+                    return {};
+            }
+            if constexpr (std::same_as<Key, ChartIndex>)
+            {
+                if (abstract_index.sort() == ChartSort::None)
+                    return {};
+            }
+            return toc.offset(abstract_index);
+        }
+        else
+        {
+            return {};
+        }
+    }
+
+    template<index_like::Algebra Key>
+    Node& Loader::enqueue(Key abstract_index)
     {
         NodeKey key(abstract_index);
         auto [it, inserted] = all_nodes.emplace(key, key);
         if (inserted)
         {
-            load(*this, it->second, abstract_index);
             // if we referenced the node before we can remove it now.
             referenced_nodes.erase(key);
+            if (snapshot != nullptr and queue_restore(it->second))
+                return it->second;
+
+            const auto offset = order == LoadOrder::Address ? locate(abstract_index) : ByteOffset{};
+            pending.push_back({&it->second, index_like::rep(abstract_index), &load_pending<Key>, offset});
         }
         return it->second;
     }
 
+    inline Node& Loader::enqueue(NodeKey key)
+    {
+        return key.visit([this](auto index) -> Node& { return enqueue(index); });
+    }
+
+    inline void Loader::drain()
+    {
+        // Nested requests only queue their work; the outermost one does the loading.
+        if (draining)
+            return;
+
+        draining = true;
+        try
+        {
+            if (order == LoadOrder::DepthFirst)
+            {
+                while (not pending.empty())
+                {
+                    const auto item = pending.back();
+                    pending.pop_back();
+                    current = item.node;
+                    item.load(*this, *item.node, item.index);
+                }
+            }
+            else
+            {
+                // Take everything queued so far as a batch; the nodes it discovers form the next one.
+                while (not pending.empty())
+                {
+                    batch.swap(pending);
+                    std::stable_sort(batch.begin(), batch.end(), [](const PendingLoad& x, const PendingLoad& y) {
+                        return x.offset < y.offset;
+                    });
+                    for (const auto& item : batch)
+                    {
+                        current = item.node;
+                        item.load(*this, *item.node, item.index);
+                    }
+                    batch.clear();
+                }
+            }
+        }
+        catch (...)
+        {
+            pending.clear();
+            batch.clear();
+            current  = nullptr;
+            draining = false;
+            throw;
+        }
+        current  = nullptr;
+        draining = false;
+    }
+
+    template<index_like::Algebra Key>
+    const Node& Loader::get(Key abstract_index)
+    {
+        Node& node = enqueue(abstract_index);
+        drain();
+        return node;
+    }
+
     inline const Node& Loader::get(NodeKey key)
     {
         return key.visit([this](auto index) -> const Node& { return get(index); });
@@ -0,0 +1,54 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// A cache of opened IFC files, for a process answering many queries about them.
+//
+// A file is read, and its entities indexed by name (see interface.hxx), the first time it
+// is asked for.  It stays open until it changes on disk, in size or modification time;
+// it is then read again the next time it is asked for.  Those who still hold the former
+// contents keep them until they let go.
+
+#ifndef IFC_UTIL_REPOSITORY_H
+#define IFC_UTIL_REPOSITORY_H
+
+#include "ifc/dom/interface.hxx"
+#include "ifc/dom/modules.hxx"
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace ifc::util {
+    struct OpenedIfc {
+        std::unique_ptr<Module> module;
+        std::filesystem::file_time_type mtime;
+        uint64_t size;
+        std::vector<Entity> entities; // all of them, sorted by name
+
+        // The entity of that name, and its overloads.
+        gsl::span<const Entity> find(std::string_view name) const;
+    };
+
+    class Repository {
+    public:
+        // The entities of a file are found by `jobs` threads, see interface_entities().
+        explicit Repository(unsigned jobs_ = 0) : jobs(jobs_) {}
+
+        // The file, opened if needed.  It can be asked for by several threads at once; the DOM
+        // of a file is not shared, so each thread needs its own Loader.
+        std::shared_ptr<const OpenedIfc> open(const std::filesystem::path& path);
+
+        // The paths of the files opened.
+        std::vector<std::filesystem::path> files() const;
+
+    private:
+        unsigned jobs;
+        mutable std::mutex mutex;
+        std::map<std::filesystem::path, std::shared_ptr<const OpenedIfc>> opened;
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_REPOSITORY_H
@@ -0,0 +1,78 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// An index of the IFC files found in a set of directories, by the name of their unit.
+//
+// The index is built from the headers of the files, without reading the rest: the unit
+// sort, the module or header name from the string table, and the content hash.  It can
+// be saved to a file and loaded back; an update then reads again only the files whose
+// size or modification time changed, drops those that are gone, and adds the new ones.
+
+#ifndef IFC_UTIL_RESOLVER_H
+#define IFC_UTIL_RESOLVER_H
+
+#include "ifc/dom/modules.hxx"
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace ifc::util {
+    struct IndexedModule {
+        ModuleName name;
+        UnitSort sort;
+        SHA256Hash content_hash;
+        uint64_t size;
+        int64_t mtime; // ticks of the file clock
+    };
+
+    // The number of files looked at, read and dropped by an update.
+    struct IndexUpdate {
+        std::size_t scanned = 0;
+        std::size_t read    = 0;
+        std::size_t removed = 0;
+    };
+
+    // The unit of the IFC file, from its header alone; nothing if the file is not an IFC, or
+    // is the IFC of a translation unit that is neither a module nor a header unit.
+    std::optional<IndexedModule> read_unit(const std::filesystem::path& path);
+
+    class ModuleIndex {
+    public:
+        // The .ifc files in the directories and their subdirectories are indexed.
+        explicit ModuleIndex(std::vector<std::filesystem::path> directories);
+
+        // Read a saved index.  This predicate does not hold if the file could not be read, or was
+        // written by another version; the index is then left empty.
+        bool load(const std::filesystem::path& file);
+
+        // Write the index.  An exception is raised if the file cannot be written.
+        void save(const std::filesystem::path& file) const;
+
+        // Bring the index in line with the directories.
+        IndexUpdate update();
+
+        // The file of the unit of that name, if any.  If several files hold the unit, the first one
+        // found in the order of the directories wins.
+        std::optional<std::filesystem::path> find(const ModuleName& name) const;
+
+        // The indexed files, by path.
+        const std::map<std::filesystem::path, IndexedModule>& files() const
+        {
+            return entries;
+        }
+
+        // A resolver looking up this index, which must outlive it.
+        ModuleResolver resolver() const;
+
+    private:
+        std::vector<std::filesystem::path> directories;
+        std::map<std::filesystem::path, IndexedModule> entries;
+        std::map<ModuleName, std::filesystem::path> by_name;
+
+        void rebuild_names();
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_RESOLVER_H
@@ -0,0 +1,130 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// A snapshot is a compact, position-independent image of the nodes held by a Loader:
+// their ids, properties, child edges and references.  It is stamped with the content
+// hash of the IFC it was derived from, and it is read in place (e.g. from a mapped file)
+// without any decoding pass: its records are only checked against its bounds.  A Loader
+// with an attached snapshot populates the nodes the snapshot has from it instead of from
+// the IFC, lazily, as they are requested.
+//
+// Layout: a SnapshotHeader, followed by the node records sorted by key, the property
+// records, the edge records (keys of children and references) and the string bytes.
+// All records are 4-byte aligned.
+
+#ifndef IFC_UTIL_SNAPSHOT_H
+#define IFC_UTIL_SNAPSHOT_H
+
+#include "ifc/dom/node.hxx"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ifc::util {
+    namespace snapshot {
+        inline constexpr uint32_t magic   = 0x53444649; // "IFDS"
+        inline constexpr uint32_t version = 1;
+
+        // Location of a string in the string bytes of a snapshot.
+        struct StringRef {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        struct Key {
+            SortKind kind;
+            uint16_t sort;
+            uint32_t index;
+        };
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            SHA256Hash content_hash;
+            uint32_t node_count;
+            uint32_t property_count;
+            uint32_t edge_count;
+            uint32_t string_bytes;
+        };
+
+        struct NodeRecord {
+            Key key;
+            StringRef id;
+            uint32_t first_property;
+            uint32_t property_count;
+            uint32_t first_child;
+            uint32_t child_count;
+            uint32_t first_reference;
+            uint32_t reference_count;
+        };
+
+        struct PropertyRecord {
+            StringRef name;
+            StringRef value;
+        };
+    } // namespace snapshot
+
+    // Exception tag used to signal that a sequence of bytes is not a valid snapshot of the current version.
+    struct InvalidSnapshot {};
+
+    // Read-only view of a snapshot.  The bytes must outlive the view.
+    class Snapshot {
+    public:
+        // Every record is checked against the sections of the snapshot: an InvalidSnapshot is
+        // raised if any is out of bounds.
+        explicit Snapshot(gsl::span<const std::byte> bytes);
+
+        const SHA256Hash& content_hash() const
+        {
+            return header->content_hash;
+        }
+
+        // True if the snapshot was taken from an IFC with the given header.
+        bool matches(const Header& ifc_header) const;
+
+        // Position of the node record with the given key, if any.
+        const snapshot::NodeRecord* find(NodeKey key) const;
+
+        gsl::span<const snapshot::NodeRecord> nodes() const
+        {
+            return node_records;
+        }
+
+        gsl::span<const snapshot::PropertyRecord> properties(const snapshot::NodeRecord& node) const
+        {
+            return property_records.subspan(node.first_property, node.property_count);
+        }
+
+        gsl::span<const snapshot::Key> children(const snapshot::NodeRecord& node) const
+        {
+            return edges.subspan(node.first_child, node.child_count);
+        }
+
+        gsl::span<const snapshot::Key> references(const snapshot::NodeRecord& node) const
+        {
+            return edges.subspan(node.first_reference, node.reference_count);
+        }
+
+        std::string_view string(snapshot::StringRef str) const
+        {
+            return strings.substr(str.offset, str.length);
+        }
+
+    private:
+        const snapshot::Header* header;
+        gsl::span<const snapshot::NodeRecord> node_records;
+        gsl::span<const snapshot::PropertyRecord> property_records;
+        gsl::span<const snapshot::Key> edges;
+        std::string_view strings;
+    };
+
+    // Serialize all the nodes loaded so far, stamped with the content hash of the loader's IFC.
+    std::vector<std::byte> write_snapshot(const Loader& loader);
+
+    // File name of the snapshot for an IFC with the given content hash, e.g. "0123...cdef.ifcdom".
+    std::string snapshot_file_name(const SHA256Hash& hash);
+} // namespace ifc::util
+
+#endif // IFC_UTIL_SNAPSHOT_H
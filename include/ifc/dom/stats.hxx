@@ -0,0 +1,68 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Size report of an IFC: where its bytes go, and what fills them.
+//
+// The report lists each partition of the table of contents with its entry count and size,
+// counts the sorts of the abstract references in each heap, estimates how much of the
+// string table is taken by repeated strings, counts the distinct types among the type
+// records, and names the scopes with the most members.  It is computed from the partitions,
+// without building the DOM.
+
+#ifndef IFC_UTIL_STATS_H
+#define IFC_UTIL_STATS_H
+
+#include "ifc/reader.hxx"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace ifc::util {
+    struct PartitionStats {
+        std::string_view name;
+        uint32_t count;
+        uint32_t entry_size;
+        uint64_t bytes;
+    };
+
+    struct SortCount {
+        const char* sort;
+        uint64_t count;
+    };
+
+    // Number of references of each sort in a heap, e.g. "heap.type".
+    struct HeapHistogram {
+        std::string_view heap;
+        std::vector<SortCount> sorts; // by decreasing count, without the sorts not found
+    };
+
+    struct StringTableStats {
+        uint64_t bytes           = 0;
+        uint64_t strings         = 0;
+        uint64_t distinct        = 0;
+        uint64_t duplicate_bytes = 0; // bytes taken by the repetitions of a string, terminator included
+    };
+
+    struct ScopeSize {
+        std::string name; // qualified name of the scope declaration
+        uint32_t members;
+    };
+
+    struct IfcStats {
+        uint64_t file_bytes = 0;
+        std::vector<PartitionStats> partitions; // by decreasing size
+        std::vector<HeapHistogram> heaps;
+        StringTableStats strings;
+        uint64_t type_records   = 0;
+        uint64_t distinct_types = 0; // see canonical.hxx
+        std::vector<ScopeSize> largest_scopes; // by decreasing member count
+    };
+
+    IfcStats compute_stats(Reader& reader, std::size_t top_scopes);
+
+    // Print the report, as aligned plain text.
+    void print_stats(const IfcStats& stats, std::ostream& out);
+} // namespace ifc::util
+
+#endif // IFC_UTIL_STATS_H
@@ -0,0 +1,76 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// A persistent index of the declarations of the IFC files found in a set of directories,
+// by name.
+//
+// Each declaration that is a member of a scope (see declared_names() in grep.hxx) is found
+// by its qualified name and by its identifier, the last component of that name.  The index
+// is a file with the names sorted, each followed by the list of declarations of that name,
+// its postings; a query maps the file in memory and looks the name up by binary search,
+// without reading the rest.  The postings of a name are sorted by file, then declaration,
+// and written as variable-length differences.
+//
+// The files are identified by the content hash in their header.  Building the index again
+// reads only the files whose hash is not in the previous index: the postings of the others
+// are taken from it.
+
+#ifndef IFC_UTIL_SYMBOLS_H
+#define IFC_UTIL_SYMBOLS_H
+
+#include "ifc/abstract-sgraph.hxx"
+
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace ifc::util {
+    // The number of IFC files found, read and dropped since the previous index, and those that
+    // could not be read.
+    struct SymbolIndexUpdate {
+        std::size_t scanned = 0;
+        std::size_t read    = 0;
+        std::size_t removed = 0;
+        std::vector<std::filesystem::path> failed;
+    };
+
+    // Write the index of the .ifc files in the directories and their subdirectories to `file`,
+    // updating the index already there if any.  The files are read by `jobs` threads (by
+    // default, one per hardware thread).  An exception is raised if the index cannot be written.
+    SymbolIndexUpdate build_symbol_index(const std::vector<std::filesystem::path>& directories,
+                                         const std::filesystem::path& file, unsigned jobs = 0);
+
+    struct SymbolPosting {
+        std::string_view path;   // of the IFC file
+        std::string_view module; // name of its unit, see to_string(const ModuleName&)
+        std::string_view name;   // qualified name of the declaration
+        DeclIndex decl;
+    };
+
+    class SymbolIndex {
+    public:
+        // Map the index in memory.  An exception is raised if the file is not an index, or was
+        // written by another version.
+        explicit SymbolIndex(const std::filesystem::path& file);
+        ~SymbolIndex();
+
+        SymbolIndex(const SymbolIndex&)            = delete;
+        SymbolIndex& operator=(const SymbolIndex&) = delete;
+
+        // The declarations of that qualified name, or identifier; a leading "::" is ignored.  The
+        // views are into the mapped file.
+        std::vector<SymbolPosting> find(std::string_view name) const;
+
+        std::size_t file_count() const;
+        std::size_t name_count() const;
+
+    private:
+        friend SymbolIndexUpdate build_symbol_index(const std::vector<std::filesystem::path>&,
+                                                    const std::filesystem::path&, unsigned);
+        struct Mapping;
+        std::unique_ptr<Mapping> mapping;
+    };
+} // namespace ifc::util
+
+#endif // IFC_UTIL_SYMBOLS_H
@@ -6,6 +6,7 @@
 
 #include <string_view>
 #include <string>
+#include <vector>
 #include <filesystem>
 
 namespace ifc {
@@ -35,6 +36,27 @@ namespace ifc::tool {
         virtual Name name() const = 0;
         virtual int run_with(const Arguments&) const = 0;
     };
+
+    // -- Extensions linked into the `ifc` tool, besides its builtin subcommands.
+    inline std::vector<const Extension*>& linked_extensions()
+    {
+        static std::vector<const Extension*> extensions;
+        return extensions;
+    }
+
+    // -- A namespace-scope object of this type adds an extension linked into the `ifc` tool
+    //    to its subcommands.
+    struct Registration {
+        explicit Registration(const Extension& ext) { linked_extensions().push_back(&ext); }
+    };
+
+    // -- An extension built as a shared object, ifc-<cmd>.dll on Windows and libifc-<cmd>.so
+    //    elsewhere, exports a function of this type named by `extension_entry`:
+    //        extern "C" const ifc::tool::Extension* ifc_tool_extension();
+    //    The `ifc` tool looks for the shared object next to its executable, then along the
+    //    search path of the system loader.
+    using ExtensionEntry = const Extension* (*)();
+    inline constexpr const char* extension_entry = "ifc_tool_extension";
 }
 
 #endif
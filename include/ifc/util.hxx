@@ -4,10 +4,82 @@
 #ifndef IFC_UTILS_H
 #define IFC_UTILS_H
 
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <version>
 #include "ifc/abstract-sgraph.hxx"
 
+#if __cpp_lib_format
+#include <format>
+#endif
+
 namespace ifc::util {
+    // The capacity of a caller-provided buffer sufficient for any format_to() below.
+    inline constexpr std::size_t format_buffer_size = 256;
+
+    // format_to(buf, x) writes the same characters as to_string(x) into `buf` without
+    // allocating, and returns a pointer past the last character written.  `buf` must have
+    // room for at least format_buffer_size characters.
+
+    char* format_to(char* buf, BasicSpecifiers basic);
+    char* format_to(char* buf, ReachableProperties reachable);
+    char* format_to(char* buf, Qualifier qual);
+    char* format_to(char* buf, ScopeTraits traits);
+    char* format_to(char* buf, ObjectTraits traits);
+    char* format_to(char* buf, FunctionTraits traits);
+    char* format_to(char* buf, GuideTraits traits);
+    char* format_to(char* buf, symbolic::BaseClassTraits traits);
+
+    namespace detail {
+        inline char* append(char* buf, std::string_view str)
+        {
+            return std::copy(str.begin(), str.end(), buf);
+        }
+
+        inline char* append(char* buf, uint32_t value)
+        {
+            // 10 digits are enough for any 32-bit value.
+            return std::to_chars(buf, buf + 10, value).ptr;
+        }
+    } // namespace detail
+
+    // write a string of the form "decl.variable-N" for various abstract indices
+    template<index_like::MultiSorted Key>
+    char* format_to(char* buf, Key index)
+    {
+        buf    = detail::append(buf, sort_name(index.sort()));
+        *buf++ = '-';
+        return detail::append(buf, ifc::to_underlying(index.index()));
+    }
+
+    inline char* format_to(char* buf, SentenceIndex index)
+    {
+        return detail::append(detail::append(buf, "sentence-"), ifc::to_underlying(index));
+    }
+
+    inline char* format_to(char* buf, ScopeIndex index)
+    {
+        return detail::append(detail::append(buf, "scope-"), ifc::to_underlying(index));
+    }
+
+    // This predicate holds for the index and flag types that have a format_to() overload.
+    template<typename T>
+    concept Formattable = requires(char* buf, T value) {
+        { ifc::util::format_to(buf, value) } -> std::same_as<char*>;
+    };
+
+    // Append the string form of a formattable value to `out` without an intermediate string.
+    template<Formattable T>
+    void append_to(std::string& out, T value)
+    {
+        char buf[format_buffer_size];
+        out.append(buf, ifc::util::format_to(buf, value));
+    }
+
     // return a single string for various IFC flags and enums
 
     std::string to_string(Access access);
@@ -45,17 +117,34 @@ namespace ifc::util {
     template<index_like::MultiSorted Key>
     std::string to_string(Key index)
     {
-        return sort_name(index.sort()) + ("-" + std::to_string(ifc::to_underlying(index.index())));
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, index)};
     }
 
     inline std::string to_string(SentenceIndex index)
     {
-        return "sentence-" + std::to_string(ifc::to_underlying(index));
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, index)};
     }
 
     inline std::string to_string(ScopeIndex index)
     {
-        return "scope-" + std::to_string(ifc::to_underlying(index));
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, index)};
     }
 } // namespace ifc::util
+
+#if __cpp_lib_format
+// std::format support, e.g. std::format_to(out, "{}", decl_index), going through util::format_to.
+template<ifc::util::Formattable T>
+struct std::formatter<T, char> : std::formatter<std::string_view, char> {
+    auto format(T value, std::format_context& ctx) const
+    {
+        char buf[ifc::util::format_buffer_size];
+        const std::string_view str{buf, ifc::util::format_to(buf, value)};
+        return std::formatter<std::string_view, char>::format(str, ctx);
+    }
+};
+#endif
+
 #endif // IFC_UTILS_H
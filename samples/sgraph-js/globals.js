@@ -75,7 +75,8 @@ const ifc_explorer = {
 // Scripting globals
 var graph = {
     data: {
-        original_data: null
+        original_data: null,
+        layout: null
     },
     drawing: {
         native_width: 1260.0,
@@ -14,6 +14,7 @@ function log_header(header) {
 }
 
 function log_string_table(string_table) {
+    // Only the strings used so far.
     console.log(string_table.strings);
 }
 
@@ -34,126 +35,6 @@ function log_decl(resolver, decl) {
     }
 }
 
-function json_for_scope(resolver, index, template_name, root) {
-    const scope_decl = resolver.read(ScopeDecl, index.index);
-    var scope_name = template_name;
-    if (scope_name == null)
-        scope_name = append_name_meta(resolver.resolve_name_index(scope_decl.identity.name), index);
-    if (!null_scope(scope_decl.initializer)) {
-        var nested_root = { };
-        const scope = resolver.decls_for_scope(scope_decl.initializer);
-        // Defined, but no members.
-        if (scope.length == 0) {
-            root[scope_name] = 1;
-        }
-        else {
-            for (var i = 0; i < scope.length; ++i) {
-                const decl = scope[i];
-                build_json(resolver, decl, nested_root);
-            }
-            root[scope_name] = nested_root;
-        }
-    }
-    else {
-        root[scope_name] = 1;
-    }
-}
-
-function json_for_enumeration(resolver, index, root) {
-    const enum_decl = resolver.read(EnumerationDecl, index.index);
-    const enum_name = append_name_meta(resolver.resolve_text_offset(enum_decl.identity.name), index);
-    if (enum_decl.initializer.cardinality == 0) {
-        root[enum_name] = 1;
-    }
-    else {
-        var nested_root = { };
-        const enumerators = resolver.decls_for_enumeration(enum_decl.initializer);
-        for (var i = 0; i < enumerators.length; ++i) {
-            const decl = enumerators[i];
-            build_json(resolver, decl, nested_root);
-        }
-        root[enum_name] = nested_root;
-    }
-}
-
-function json_for_parameterized_scope(resolver, template_decl, index, root) {
-    const identity = resolver.resolve_identity(template_decl.identity);
-    const name = append_name_meta(identity.name, index);
-    json_for_scope(resolver, template_decl.entity.decl, name, root);
-}
-
-function json_for_template(resolver, index, root) {
-    const template_decl = resolver.read(TemplateDecl, index.index);
-    switch (template_decl.entity.decl.sort) {
-    case DeclIndex.Sort.Scope:
-        json_for_parameterized_scope(resolver, template_decl, index, root);
-        break;
-    default:
-        json_for_unsorted(resolver, index, root);
-        break;
-    }
-}
-
-function json_for_template_specialization(resolver, index, root) {
-    var nested_root = { };
-    const specialization_decl = resolver.read(SpecializationDecl, index.index);
-    const decl = { decl: specialization_decl.decl };
-    build_json(resolver, decl, nested_root);
-    // Extract the name to populate for the specialization.
-    const symbolic = symbolic_for_decl_sort(specialization_decl.decl.sort);
-    const symbolic_decl = resolver.read(symbolic, specialization_decl.decl.index);
-    const identity = resolver.resolve_identity(symbolic_decl.identity);
-    const entry_name = `<T>{${identity.name}}`;
-    const name = append_name_meta(entry_name, index);
-    root[name] = nested_root;
-}
-
-function json_for_unsorted(resolver, index, root) {
-    const symbolic = symbolic_for_decl_sort(index.sort);
-    var symbolic_decl = resolver.read(symbolic, index.index);
-    if (symbolic_decl.identity == null) {
-        // Barren decls have no formal name, but we can still display them in a way that is useful (by using the 'sort' field).
-        if (index.sort == DeclIndex.Sort.Barren)
-        {
-            const sort = sort_to_string(DirIndex, symbolic_decl.directive.sort);
-            const idx = symbolic_decl.directive.index;
-            const entry_name = `Barren{${sort},${idx}}`;
-            const name = append_name_meta(entry_name, index);
-            root[name] = 1;
-            return;
-        }
-
-        if (index.sort == DeclIndex.Sort.Specialization)
-        {
-            json_for_template_specialization(resolver, index, root);
-            return;
-        }
-        root[`unknown_${sort_to_string(DeclIndex, index.sort)}_${index.index}`] = 1;
-        return;
-    }
-    const identity = resolver.resolve_identity(symbolic_decl.identity);
-    const name = append_name_meta(identity.name, index);
-    root[name] = 1;
-}
-
-function build_json(resolver, decl, root) {
-    //log_decl(resolver, decl);
-    switch (decl.decl.sort) {
-    case DeclIndex.Sort.Scope:
-        json_for_scope(resolver, decl.decl, null, root);
-        break;
-    case DeclIndex.Sort.Enumeration:
-        json_for_enumeration(resolver, decl.decl, root);
-        break;
-    case DeclIndex.Sort.Template:
-        json_for_template(resolver, decl.decl, root);
-        break;
-    default:
-        json_for_unsorted(resolver, decl.decl, root);
-        break;
-    }
-}
-
 function implies(x, y) {
     return (x & y) == y;
 }
@@ -216,14 +97,6 @@ function read_ifc(reader, header) {
     //log_partitions(toc, string_table);
     var resolver = new Resolver(reader, toc, string_table);
     init_sgraph(resolver, header);
-    var global_scope = resolver.decls_for_scope(header.scope_index);
-    var json = { };
-    json["global"] = { };
-    for (var i = 0; i < global_scope.length; ++i) {
-        var decl = global_scope[i];
-        build_json(resolver, decl, json["global"]);
-    }
-    init_graph(json);
 }
 
 function display_ifc_info(file) {
@@ -270,6 +143,68 @@ function valid_ifc_version(header) {
     return false;
 }
 
+function show_ifc(file, buffer, tree, layout) {
+    var reader = new RawByteReader(new Uint8Array(buffer));
+    const header = new Header(reader);
+    read_ifc(reader, header);
+    // The layout written by `ifc layout` already holds the tree, laid out.
+    if (layout != null)
+        init_graph_from_layout(layout);
+    else
+        init_graph(tree);
+    display_ifc_info(file);
+    ifc_explorer_ifc_loaded();
+    graph.element.hidden = false;
+}
+
+// Build the tree in tree-worker.js, keeping the page responsive, or right here where workers
+// cannot be started (e.g. for a page opened from file://).
+function build_tree_off_thread(file, buffer, done) {
+    const build_here = (buffer) => done(build_tree(new Uint8Array(buffer)), buffer);
+    var worker = null;
+    try {
+        worker = new Worker('tree-worker.js');
+    }
+    catch (e) {
+        build_here(buffer);
+        return;
+    }
+    worker.onmessage = event => {
+        worker.terminate();
+        done(event.data.tree, event.data.buffer);
+    };
+    worker.onerror = event => {
+        event.preventDefault();
+        worker.terminate();
+        // The buffer went to the worker: read the file again.
+        file.arrayBuffer().then(build_here);
+    };
+    worker.postMessage({ buffer: buffer }, [ buffer ]);
+}
+
+function load_ifc(file, layout) {
+    const reader = new FileReader();
+    reader.addEventListener('load', (event) => {
+        console.log("file read.");
+        console.log("byte length: ", event.target.result.byteLength);
+        const buffer = event.target.result;
+        const header = new Header(new RawByteReader(new Uint8Array(buffer)));
+        if (!header.valid()) {
+            output.textContent = "invalid IFC";
+            return;
+        }
+        if (!valid_ifc_version(header))
+            return;
+        if (layout != null) {
+            show_ifc(file, buffer, null, layout);
+            return;
+        }
+        output.textContent = "Reading declarations...";
+        build_tree_off_thread(file, buffer, (tree, buffer) => show_ifc(file, buffer, tree, null));
+    });
+    reader.readAsArrayBuffer(file);
+}
+
 if (window.FileList && window.File) {
     file_selector.addEventListener('dragover', event => {
         event.stopPropagation();
@@ -284,30 +219,30 @@ if (window.FileList && window.File) {
             console.error("Bad sort detected");
             return;
         }
-        if (files.length != 1) {
+        // An IFC, optionally along with its layout from `ifc layout`.
+        const layout_files = Array.from(files).filter(f => f.name.endsWith(".ifclayout"));
+        const ifc_files = Array.from(files).filter(f => !f.name.endsWith(".ifclayout"));
+        if (ifc_files.length != 1 || layout_files.length > 1) {
             output.textContent = "One IFC at a time, please.";
             return;
         }
-        const file = files[0];
-        const reader = new FileReader();
-        reader.addEventListener('load', (event) => {
-            console.log("file read.");
-            console.log("byte length: ", event.target.result.byteLength);
-            const view = new Uint8Array(event.target.result);
-            var reader = new RawByteReader(view);
-            const header = new Header(reader);
-            if (!header.valid()) {
-                output.textContent = "invalid IFC";
-                return;
+        if (layout_files.length == 0) {
+            load_ifc(ifc_files[0], null);
+            return;
+        }
+        const layout_reader = new FileReader();
+        layout_reader.addEventListener('load', (event) => {
+            var layout = null;
+            try {
+                layout = new Layout(event.target.result);
             }
-            if (!valid_ifc_version(header))
+            catch (e) {
+                output.textContent = "invalid IFC layout";
                 return;
-            read_ifc(reader, header);
-            display_ifc_info(file);
-            ifc_explorer_ifc_loaded();
-            graph.element.hidden = false;
+            }
+            load_ifc(ifc_files[0], layout);
         });
-        reader.readAsArrayBuffer(file);
+        layout_reader.readAsArrayBuffer(layout_files[0]);
     });
 }
 
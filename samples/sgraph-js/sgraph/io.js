@@ -1,42 +1,41 @@
 // Copyright Microsoft Corporation.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+// Reads straight out of the bytes of the IFC: no value read allocates, except strings.
 class RawByteReader {
+    static decoder = new TextDecoder("utf-8");
+
     constructor(bytes) {
         this.bytes = bytes;
+        this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
         this.offset = 0;
     }
 
     read_uint8() {
-        const byte = this.bytes[this.offset];
+        const byte = this.view.getUint8(this.offset);
         this.offset += 1;
         return byte;
     }
 
     read_uint16() {
-        const array8 = new Uint8Array([ this.read_uint8(),
-                                        this.read_uint8() ]);
-        const array16 = new Uint16Array(array8.buffer);
-        const uint16 = array16[0];
+        const uint16 = this.view.getUint16(this.offset, true);
+        this.offset += 2;
         return uint16;
     }
 
     read_uint32() {
-        const array8 = new Uint8Array([ this.read_uint8(),
-                                        this.read_uint8(),
-                                        this.read_uint8(),
-                                        this.read_uint8() ]);
-        const array32 = new Uint32Array(array8.buffer);
-        const uint32 = array32[0];
+        const uint32 = this.view.getUint32(this.offset, true);
+        this.offset += 4;
         return uint32;
     }
 
     read_null_terminated_string() {
-        var array = new Array();
-        for (var byte = this.read_uint8(); byte != 0; byte = this.read_uint8()) {
-            array.push(byte);
-        }
-        return String.fromCharCode.apply(String, array);
+        var end = this.bytes.indexOf(0, this.offset);
+        if (end == -1)
+            end = this.bytes.length;
+        const str = RawByteReader.decoder.decode(this.bytes.subarray(this.offset, end));
+        this.offset = end + 1;
+        return str;
     }
 
     static bit_width(n) {
@@ -172,21 +171,23 @@ class CPlusPlus {
     }
 }
 
+// Strings are decoded on first use, and kept.
 class StringTable {
     constructor(reader, offset, size) {
+        this.bytes = reader.bytes.subarray(offset, offset + size);
         this.strings = new Map();
-        reader.seek(offset);
-        while ((reader.offset - offset) < size) {
-            var key = reader.offset - offset;
-            var str = reader.read_null_terminated_string();
-            this.strings.set(key, str);
-            //console.log("string_table[", key, "] =", str); // More logging if necessary.
-        }
-        //console.log("String table built.  Byte offset =", offset, " size =", size, " iterated =", (reader.offset - offset)); // More logging if necessary.
     }
 
     get(offset) {
-        return this.strings.get(offset);
+        var str = this.strings.get(offset);
+        if (str === undefined && offset < this.bytes.length) {
+            var end = this.bytes.indexOf(0, offset);
+            if (end == -1)
+                end = this.bytes.length;
+            str = RawByteReader.decoder.decode(this.bytes.subarray(offset, end));
+            this.strings.set(offset, str);
+        }
+        return str;
     }
 }
 
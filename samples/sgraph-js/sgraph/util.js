@@ -1,43 +1,66 @@
-// Copyright Microsoft Corporation.
-// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
-
-function has_property(obj, prop) {
-    return obj.hasOwnProperty(prop);
-}
-
-function is_object(obj) {
-    return typeof obj === 'object';
-}
-
-function remove_all_children(content) {
-    // Yes, it is intentional to check for the first and remove the last.
-    while (content.firstChild != null) {
-        content.removeChild(content.lastChild);
-    }
-}
-
-function valid_integral_value(str) {
-    if (str == "")
-        return false;
-    if (isNaN(str))
-        return false;
-    return true;
-}
-
-function mark_edit_valid(edit) {
-    edit.classList.remove(invalid_css_class);
-}
-
-function mark_edit_invalid(edit, tooltip, reason) {
-    tooltip.innerHTML = reason;
-    edit.classList.add(invalid_css_class);
-}
-
-// Implementation pulled from: https://www.freecodecamp.org/news/javascript-debounce-example/
-function debounce(func, timeout = 300) {
-    let timer = undefined;
-    return (...args) => {
-        clearTimeout(timer);
-        timer = setTimeout(() => { func.apply(this, args); }, timeout);
-    };
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Names in the graph carry the index of their declaration, after delim.
+const delim = '`_';
+function is_meta_name(name) {
+    return name.includes(delim);
+}
+
+function append_name_meta(name, index) {
+    return name + `${delim}${index.sort},${index.index}`;
+}
+
+function name_from_meta(str) {
+    var parts = str.split(delim);
+    return parts[0];
+}
+
+function name_and_index_from_meta(str) {
+    var parts = str.split(delim);
+    var name = parts[0];
+    var str_index = parts[1];
+    var index_parts = str_index.split(',');
+    return { name: name, index: { sort: parseInt(index_parts[0]), index: parseInt(index_parts[1]) } };
+}
+
+function has_property(obj, prop) {
+    return obj.hasOwnProperty(prop);
+}
+
+function is_object(obj) {
+    return typeof obj === 'object';
+}
+
+function remove_all_children(content) {
+    // Yes, it is intentional to check for the first and remove the last.
+    while (content.firstChild != null) {
+        content.removeChild(content.lastChild);
+    }
+}
+
+function valid_integral_value(str) {
+    if (str == "")
+        return false;
+    if (isNaN(str))
+        return false;
+    return true;
+}
+
+function mark_edit_valid(edit) {
+    edit.classList.remove(invalid_css_class);
+}
+
+function mark_edit_invalid(edit, tooltip, reason) {
+    tooltip.innerHTML = reason;
+    edit.classList.add(invalid_css_class);
+}
+
+// Implementation pulled from: https://www.freecodecamp.org/news/javascript-debounce-example/
+function debounce(func, timeout = 300) {
+    let timer = undefined;
+    return (...args) => {
+        clearTimeout(timer);
+        timer = setTimeout(() => { func.apply(this, args); }, timeout);
+    };
 }
\ No newline at end of file
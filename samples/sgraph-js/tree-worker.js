@@ -0,0 +1,24 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Builds the tree of declarations off the main thread.  The buffer of the IFC is transferred
+// here and back, so it is never copied.
+
+importScripts('sgraph/decls.js',
+              'sgraph/dirs.js',
+              'sgraph/charts.js',
+              'sgraph/exprs.js',
+              'sgraph/io.js',
+              'sgraph/literals.js',
+              'sgraph/operators.js',
+              'sgraph/resolve.js',
+              'sgraph/sgraph.js',
+              'sgraph/types.js',
+              'sgraph/util.js',
+              'tree.js');
+
+onmessage = event => {
+    const buffer = event.data.buffer;
+    const tree = build_tree(new Uint8Array(buffer));
+    postMessage({ tree: tree, buffer: buffer }, [ buffer ]);
+};
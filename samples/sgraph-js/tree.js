@@ -0,0 +1,142 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Building of the tree of declarations drawn by the graph.  This does not touch the page,
+// so that it can run in tree-worker.js as well as on the main thread.
+
+function json_for_scope(resolver, index, template_name, root) {
+    const scope_decl = resolver.read(ScopeDecl, index.index);
+    var scope_name = template_name;
+    if (scope_name == null)
+        scope_name = append_name_meta(resolver.resolve_name_index(scope_decl.identity.name), index);
+    if (!null_scope(scope_decl.initializer)) {
+        var nested_root = { };
+        const scope = resolver.decls_for_scope(scope_decl.initializer);
+        // Defined, but no members.
+        if (scope.length == 0) {
+            root[scope_name] = 1;
+        }
+        else {
+            for (var i = 0; i < scope.length; ++i) {
+                const decl = scope[i];
+                build_json(resolver, decl, nested_root);
+            }
+            root[scope_name] = nested_root;
+        }
+    }
+    else {
+        root[scope_name] = 1;
+    }
+}
+
+function json_for_enumeration(resolver, index, root) {
+    const enum_decl = resolver.read(EnumerationDecl, index.index);
+    const enum_name = append_name_meta(resolver.resolve_text_offset(enum_decl.identity.name), index);
+    if (enum_decl.initializer.cardinality == 0) {
+        root[enum_name] = 1;
+    }
+    else {
+        var nested_root = { };
+        const enumerators = resolver.decls_for_enumeration(enum_decl.initializer);
+        for (var i = 0; i < enumerators.length; ++i) {
+            const decl = enumerators[i];
+            build_json(resolver, decl, nested_root);
+        }
+        root[enum_name] = nested_root;
+    }
+}
+
+function json_for_parameterized_scope(resolver, template_decl, index, root) {
+    const identity = resolver.resolve_identity(template_decl.identity);
+    const name = append_name_meta(identity.name, index);
+    json_for_scope(resolver, template_decl.entity.decl, name, root);
+}
+
+function json_for_template(resolver, index, root) {
+    const template_decl = resolver.read(TemplateDecl, index.index);
+    switch (template_decl.entity.decl.sort) {
+    case DeclIndex.Sort.Scope:
+        json_for_parameterized_scope(resolver, template_decl, index, root);
+        break;
+    default:
+        json_for_unsorted(resolver, index, root);
+        break;
+    }
+}
+
+function json_for_template_specialization(resolver, index, root) {
+    var nested_root = { };
+    const specialization_decl = resolver.read(SpecializationDecl, index.index);
+    const decl = { decl: specialization_decl.decl };
+    build_json(resolver, decl, nested_root);
+    // Extract the name to populate for the specialization.
+    const symbolic = symbolic_for_decl_sort(specialization_decl.decl.sort);
+    const symbolic_decl = resolver.read(symbolic, specialization_decl.decl.index);
+    const identity = resolver.resolve_identity(symbolic_decl.identity);
+    const entry_name = `<T>{${identity.name}}`;
+    const name = append_name_meta(entry_name, index);
+    root[name] = nested_root;
+}
+
+function json_for_unsorted(resolver, index, root) {
+    const symbolic = symbolic_for_decl_sort(index.sort);
+    var symbolic_decl = resolver.read(symbolic, index.index);
+    if (symbolic_decl.identity == null) {
+        // Barren decls have no formal name, but we can still display them in a way that is useful (by using the 'sort' field).
+        if (index.sort == DeclIndex.Sort.Barren)
+        {
+            const sort = sort_to_string(DirIndex, symbolic_decl.directive.sort);
+            const idx = symbolic_decl.directive.index;
+            const entry_name = `Barren{${sort},${idx}}`;
+            const name = append_name_meta(entry_name, index);
+            root[name] = 1;
+            return;
+        }
+
+        if (index.sort == DeclIndex.Sort.Specialization)
+        {
+            json_for_template_specialization(resolver, index, root);
+            return;
+        }
+        root[`unknown_${sort_to_string(DeclIndex, index.sort)}_${index.index}`] = 1;
+        return;
+    }
+    const identity = resolver.resolve_identity(symbolic_decl.identity);
+    const name = append_name_meta(identity.name, index);
+    root[name] = 1;
+}
+
+function build_json(resolver, decl, root) {
+    //log_decl(resolver, decl);
+    switch (decl.decl.sort) {
+    case DeclIndex.Sort.Scope:
+        json_for_scope(resolver, decl.decl, null, root);
+        break;
+    case DeclIndex.Sort.Enumeration:
+        json_for_enumeration(resolver, decl.decl, root);
+        break;
+    case DeclIndex.Sort.Template:
+        json_for_template(resolver, decl.decl, root);
+        break;
+    default:
+        json_for_unsorted(resolver, decl.decl, root);
+        break;
+    }
+}
+
+// The tree of declarations of the IFC in the bytes, rooted at "global".
+function build_tree(bytes) {
+    var reader = new RawByteReader(bytes);
+    const header = new Header(reader);
+    var string_table = new StringTable(reader, header.string_table_offset, header.string_table_size);
+    var toc = new ToC(reader, header, string_table);
+    var resolver = new Resolver(reader, toc, string_table);
+    var global_scope = resolver.decls_for_scope(header.scope_index);
+    var json = { };
+    json["global"] = { };
+    for (var i = 0; i < global_scope.length; ++i) {
+        var decl = global_scope[i];
+        build_json(resolver, decl, json["global"]);
+    }
+    return json;
+}
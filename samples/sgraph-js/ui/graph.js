@@ -75,6 +75,26 @@ class PartitionDataHelper
     }
 }
 
+// Partition computed ahead of time by `ifc layout`: the coordinates are only scaled to the canvas.
+class PrecomputedPartitionHelper
+{
+    constructor(root) {
+        this.root = root;
+    }
+
+    partition() {
+        const w = width();
+        const h = height();
+        this.root.each(function(d) {
+            const layout = d.data.layout;
+            d.x0 = layout.x0 * w;
+            d.x1 = layout.x1 * w;
+            d.y0 = layout.y0 * h;
+            d.y1 = layout.y1 * h;
+        });
+    }
+}
+
 // Breadcrumb dimensions: width, height, spacing, width of tip/tail.
 var b = {
     w: 150, h: 30, s: 3, t: 10
@@ -82,28 +102,6 @@ var b = {
 
 var total_size = 0;
 
-const delim = '`_';
-function is_meta_name(name) {
-    return name.includes(delim);
-}
-
-function append_name_meta(name, index) {
-    return name + `${delim}${index.sort},${index.index}`;
-}
-
-function name_from_meta(str) {
-    var parts = str.split(delim);
-    return parts[0];
-}
-
-function name_and_index_from_meta(str) {
-    var parts = str.split(delim);
-    var name = parts[0];
-    var str_index = parts[1];
-    var index_parts = str_index.split(',');
-    return { name: name, index: { sort: parseInt(index_parts[0]), index: parseInt(index_parts[1]) } };
-}
-
 function color_for_index(index) {
     return options.color_for_index(index);
 }
@@ -420,7 +418,31 @@ function build_graph_data(root) {
         .sum(function(d) { return d.value })
         .sort(function(a, b) { return b.value - a.value; });
 
-    graph.drawing.partition = new PartitionDataHelper(root);
+    bind_graph_data(root, new PartitionDataHelper(root));
+}
+
+// Build the graph from a Layout (see layout.js), whose nodes are stored parents first
+// and with the children of each node in drawing order.
+function build_graph_data_from_layout(layout) {
+    var data = layout.nodes.map(n => ({ key: n.key(), layout: n, children: [] }));
+    for (var i = 1; i < data.length; ++i)
+        data[data[i].layout.parent].children.push(data[i]);
+    var root = d3.hierarchy(data[0], function(d) { return d.children; });
+    root.each(function(d) { d.value = d.data.layout.value; });
+
+    bind_graph_data(root, new PrecomputedPartitionHelper(root));
+}
+
+// Rebuild the graph of the whole IFC.
+function build_original_graph_data() {
+    if (graph.data.layout != null)
+        build_graph_data_from_layout(graph.data.layout);
+    else
+        build_graph_data(graph.data.original_data);
+}
+
+function bind_graph_data(root, partition) {
+    graph.drawing.partition = partition;
     graph.drawing.node_mapper = new NodeToColorMapper();
 
     graph.drawing.partition.partition();
@@ -460,12 +482,24 @@ function build_graph_data(root) {
 
 function init_graph(root) {
     graph.data.original_data = root;
+    graph.data.layout = null;
+    start_graph();
+}
+
+// Show the graph from a precomputed layout, skipping the layout in the browser.
+function init_graph_from_layout(layout) {
+    graph.data.layout = layout;
+    graph.data.original_data = layout.to_json();
+    start_graph();
+}
+
+function start_graph() {
     setup_dpi(graph_canvas.node());
     setup_dpi(render_canvas.node());
     init_breadcrumb_trail();
     // Note: we do not scale the backing-canvas because its size needs to correspond directly to unscaled
     // mouse coordinates on screen.
-    build_graph_data(root);
+    build_original_graph_data();
 
     requestAnimationFrame(animation_frame);
     function animation_frame(elapsed) {
@@ -824,13 +858,13 @@ function prune_with_graph_filter(filter) {
 }
 
 function rebuild_original_graph() {
-    build_graph_data(graph.data.original_data);
+    build_original_graph_data();
     reset_view();
 }
 
 function apply_graph_filter(filter) {
     if (filter.empty()) {
-        build_graph_data(graph.data.original_data);
+        build_original_graph_data();
         graph.drawing.working_data.attr("selected", function(d) {
             return true;
         });
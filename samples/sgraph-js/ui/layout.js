@@ -0,0 +1,100 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Reader for the precomputed layout written by `ifc layout`, see include/ifc/dom/layout.hxx.
+// The records are read straight out of the file bytes; nothing is laid out here.
+
+const LayoutFormat = {
+    magic: 0x4C434649, // "IFCL"
+    version: 1,
+    header_size: 28,
+    tile_size: 20,
+    node_size: 40,
+    edge_size: 8,
+    no_parent: 0xFFFFFFFF,
+    decl_kind: 1 // SortKind::Decl
+};
+
+class LayoutNode {
+    constructor(view, offset, labels, decoder) {
+        this.x0 = view.getFloat32(offset, true);
+        this.y0 = view.getFloat32(offset + 4, true);
+        this.x1 = view.getFloat32(offset + 8, true);
+        this.y1 = view.getFloat32(offset + 12, true);
+        this.parent = view.getUint32(offset + 16, true);
+        this.value = view.getUint32(offset + 20, true);
+        const label_offset = view.getUint32(offset + 24, true);
+        const label_length = view.getUint32(offset + 28, true);
+        this.label = decoder.decode(labels.subarray(label_offset, label_offset + label_length));
+        this.kind = view.getUint16(offset + 32, true);
+        this.sort = view.getUint16(offset + 34, true);
+        this.index = view.getUint32(offset + 36, true);
+    }
+
+    // The key used by the graph for this node: a meta name for a declaration (see graph.js).
+    key() {
+        if (this.kind != LayoutFormat.decl_kind)
+            return this.label;
+        return append_name_meta(this.label, { sort: this.sort, index: this.index });
+    }
+}
+
+class Layout {
+    constructor(buffer) {
+        const view = new DataView(buffer);
+        if (view.byteLength < LayoutFormat.header_size
+            || view.getUint32(0, true) != LayoutFormat.magic
+            || view.getUint32(4, true) != LayoutFormat.version)
+            throw new Error("not an IFC layout");
+        const tile_count = view.getUint32(8, true);
+        const node_count = view.getUint32(12, true);
+        const edge_count = view.getUint32(16, true);
+        this.depth_count = view.getUint32(20, true);
+        const label_bytes = view.getUint32(24, true);
+
+        var offset = LayoutFormat.header_size;
+        this.tiles = new Array(tile_count);
+        for (var i = 0; i < tile_count; ++i, offset += LayoutFormat.tile_size) {
+            this.tiles[i] = {
+                depth: view.getUint32(offset, true),
+                first_node: view.getUint32(offset + 4, true),
+                node_count: view.getUint32(offset + 8, true),
+                x0: view.getFloat32(offset + 12, true),
+                x1: view.getFloat32(offset + 16, true)
+            };
+        }
+
+        const nodes_offset = offset;
+        offset += node_count * LayoutFormat.node_size;
+        const edges_offset = offset;
+        offset += edge_count * LayoutFormat.edge_size;
+        const labels = new Uint8Array(buffer, offset, label_bytes);
+        const decoder = new TextDecoder("utf-8");
+
+        this.nodes = new Array(node_count);
+        for (var i = 0; i < node_count; ++i)
+            this.nodes[i] = new LayoutNode(view, nodes_offset + i * LayoutFormat.node_size, labels, decoder);
+
+        this.edges = new Array(edge_count);
+        for (var i = 0; i < edge_count; ++i) {
+            const edge_offset = edges_offset + i * LayoutFormat.edge_size;
+            this.edges[i] = { from: view.getUint32(edge_offset, true), to: view.getUint32(edge_offset + 4, true) };
+        }
+    }
+
+    // The tiles with nodes in the horizontal range [x0, x1] of the unit square.
+    tiles_in_view(x0, x1) {
+        return this.tiles.filter(t => t.x1 >= x0 && t.x0 <= x1);
+    }
+
+    // The same tree in the object form built by loader.js, used when the graph is filtered.
+    to_json() {
+        var objects = this.nodes.map(n => ({ }));
+        for (var i = this.nodes.length - 1; i > 0; --i) {
+            const node = this.nodes[i];
+            const parent = objects[node.parent];
+            parent[node.key()] = Object.keys(objects[i]).length == 0 ? 1 : objects[i];
+        }
+        return { global: objects.length == 0 ? { } : objects[0] };
+    }
+}
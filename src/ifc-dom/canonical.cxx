@@ -0,0 +1,470 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/canonical.hxx"
+
+#include <bit>
+#include <string_view>
+
+namespace ifc::util {
+    namespace {
+        constexpr uint32_t unvisited   = 0xFFFFFFFF;
+        constexpr uint32_t in_progress = 0xFFFFFFFE;
+
+        // Two 64-bit lanes with different multipliers, finalized with the MurmurHash3 mixer.
+        // The words are taken as integers, so the hashes do not depend on the platform.
+        class Mix {
+        public:
+            void add(uint64_t word)
+            {
+                a = std::rotl((a ^ word) * 0x9E3779B97F4A7C15, 29);
+                b = std::rotl((b ^ word) * 0xC2B2AE3D27D4EB4F, 31) + a;
+            }
+
+            void add(std::string_view bytes)
+            {
+                uint64_t word = 0;
+                std::size_t i = 0;
+                for (auto c : bytes)
+                {
+                    word |= uint64_t{static_cast<unsigned char>(c)} << (8 * (i % 8));
+                    if (++i % 8 == 0)
+                    {
+                        add(word);
+                        word = 0;
+                    }
+                }
+                add(word);
+                add(bytes.size());
+            }
+
+            TypeHash get() const
+            {
+                return {finish(b), finish(a)};
+            }
+
+        private:
+            uint64_t a = 0x243F6A8885A308D3;
+            uint64_t b = 0x13198A2E03707344;
+
+            static uint64_t finish(uint64_t h)
+            {
+                h ^= h >> 33;
+                h *= 0xFF51AFD7ED558CCD;
+                h ^= h >> 33;
+                h *= 0xC4CEB9FE1A85EC53;
+                h ^= h >> 33;
+                return h;
+            }
+        };
+
+        // Tags of the words that stand for something else than a type, so that, e.g., a
+        // literal bound does not hash as the position of an expression of the same value.
+        enum class Word : uint64_t {
+            Null = 0xA0,
+            Literal,
+            Identity,
+            Decl,
+            Chart,
+        };
+
+        uint64_t word(Word w)
+        {
+            return ifc::to_underlying(w);
+        }
+
+        template<index_like::MultiSorted Index>
+        uint64_t position(Index index)
+        {
+            return uint64_t{ifc::to_underlying(index.sort())} << 32 | ifc::to_underlying(index.index());
+        }
+    } // namespace
+
+    // The words and component types of each type record.  A record is hashed once the hashes of
+    // its components are known; the components are found again then, as it is cheaper than
+    // keeping them.
+    class CanonicalTypes::Builder {
+    public:
+        Builder(Reader& reader_, CanonicalTypes& out_) : reader(reader_), out(out_) {}
+
+        void resolve(TypeIndex root)
+        {
+            // Post-order walk with an explicit stack: types can nest deeply.
+            struct Step {
+                TypeIndex type;
+                bool expanded;
+            };
+            std::vector<Step> work{{root, false}};
+            while (not work.empty())
+            {
+                auto [type, expanded] = work.back();
+                auto* id = slot(type);
+                if (id == nullptr or (*id != unvisited and *id != in_progress))
+                {
+                    work.pop_back();
+                    continue;
+                }
+                if (not expanded)
+                {
+                    work.back().expanded = true;
+                    *id                  = in_progress;
+                    describe(type);
+                    // A type being hashed is a component only through a cycle, which the hash of
+                    // the dependent type then ignores.
+                    for (auto component : components)
+                    {
+                        auto* component_id = slot(component);
+                        if (component_id != nullptr and *component_id == unvisited)
+                            work.push_back({component, false});
+                    }
+                    continue;
+                }
+                work.pop_back();
+                describe(type);
+                Mix mix;
+                for (auto w : words)
+                    mix.add(w);
+                for (auto component : components)
+                {
+                    const auto h = hash_of(component);
+                    mix.add(h.high);
+                    mix.add(h.low);
+                }
+                *id = out.intern(mix.get());
+            }
+        }
+
+    private:
+        Reader& reader;
+        CanonicalTypes& out;
+        std::vector<uint64_t> words;
+        std::vector<TypeIndex> components;
+        std::unordered_map<uint64_t, TypeHash> decls;
+
+        uint32_t* slot(TypeIndex index)
+        {
+            if (index_like::null(index))
+                return nullptr;
+            auto& ids = out.ids[ifc::to_underlying(index.sort())];
+            const auto n = ifc::to_underlying(index.index());
+            return n < ids.size() ? &ids[n] : nullptr;
+        }
+
+        TypeHash hash_of(TypeIndex index)
+        {
+            if (index_like::null(index))
+                return out.distinct[0];
+            auto* id = slot(index);
+            if (id == nullptr)
+            {
+                // Outside of its partition: only its position is known.
+                Mix mix;
+                mix.add(word(Word::Identity));
+                mix.add(position(index));
+                return mix.get();
+            }
+            if (*id == in_progress)
+                return {};
+            return out.distinct[*id];
+        }
+
+        void describe(TypeIndex index)
+        {
+            words.clear();
+            components.clear();
+            words.push_back(ifc::to_underlying(index.sort()));
+            if (index.sort() == TypeSort::VendorExtension)
+            {
+                words.push_back(word(Word::Identity));
+                words.push_back(position(index));
+                return;
+            }
+            reader.visit(index, [this](const auto& type) { add(type); });
+        }
+
+        void add_hash(const TypeHash& h)
+        {
+            words.push_back(h.high);
+            words.push_back(h.low);
+        }
+
+        void add_identity(uint64_t pos)
+        {
+            words.push_back(word(Word::Identity));
+            words.push_back(pos);
+        }
+
+        void add_expr(ExprIndex index)
+        {
+            if (index_like::null(index))
+            {
+                words.push_back(word(Word::Null));
+                return;
+            }
+            if (index.sort() == ExprSort::Literal)
+            {
+                const auto value = reader.get<symbolic::LiteralExpr>(index).value;
+                words.push_back(word(Word::Literal));
+                words.push_back(ifc::to_underlying(value.sort()));
+                switch (value.sort())
+                {
+                case LiteralSort::Immediate:
+                    words.push_back(ifc::to_underlying(value.index()));
+                    return;
+                case LiteralSort::Integer:
+                    words.push_back(static_cast<uint64_t>(reader.get<int64_t>(value)));
+                    return;
+                case LiteralSort::FloatingPoint:
+                    words.push_back(std::bit_cast<uint64_t>(reader.get<double>(value)));
+                    return;
+                default:
+                    break;
+                }
+            }
+            add_identity(position(index));
+        }
+
+        void add_name(NameIndex name)
+        {
+            if (not index_like::null(name) and name.sort() == NameSort::Identifier)
+                add_name(TextOffset(ifc::to_underlying(name.index())));
+            else
+                add_identity(position(name));
+        }
+
+        void add_name(TextOffset text)
+        {
+            Mix mix;
+            mix.add(std::string_view{reader.get(text)});
+            add_hash(mix.get());
+        }
+
+        // A declaration counts as its sort and name, qualified by the enclosing declarations.
+        // A template parameter counts as its place in the template parameter lists instead.
+        const TypeHash& decl_hash(DeclIndex index)
+        {
+            auto [it, inserted] = decls.try_emplace(position(index));
+            if (not inserted)
+                return it->second;
+
+            auto saved = std::move(words);
+            words.clear();
+            words.push_back(word(Word::Decl));
+            words.push_back(ifc::to_underlying(index.sort()));
+            DeclIndex home{};
+            if (index.sort() == DeclSort::Parameter)
+            {
+                const auto& parameter = reader.get<symbolic::ParameterDecl>(index);
+                words.push_back(parameter.level);
+                words.push_back(parameter.position);
+                words.push_back(ifc::to_underlying(parameter.sort));
+            }
+            else
+            {
+                reader.visit_with_index(index, [&](DeclIndex, const auto& decl) {
+                    if constexpr (requires { decl.home_scope; })
+                        home = decl.home_scope;
+                    if constexpr (requires { decl.identity.name; })
+                        add_name(decl.identity.name);
+                    else
+                        add_identity(position(index));
+                });
+            }
+            // `it` survives the insertions made for the enclosing declarations; the placeholder
+            // is the hash seen by a malformed cycle of them.
+            it->second = {};
+            if (not index_like::null(home))
+                add_hash(decl_hash(home));
+            Mix mix;
+            for (auto w : words)
+                mix.add(w);
+            words      = std::move(saved);
+            it->second = mix.get();
+            return it->second;
+        }
+
+        void add_chart(ChartIndex index, int depth = 0)
+        {
+            words.push_back(word(Word::Chart));
+            words.push_back(ifc::to_underlying(index.sort()));
+            // The bound guards against a malformed IFC in which charts enclose one another.
+            if (depth > 64)
+                return add_identity(position(index));
+            switch (index.sort())
+            {
+            case ChartSort::Unilevel:
+            {
+                const auto& chart = reader.get<symbolic::UnilevelChart>(index);
+                const auto parameters = reader.sequence(chart);
+                words.push_back(parameters.size());
+                for (const auto& parameter : parameters)
+                {
+                    words.push_back(ifc::to_underlying(parameter.sort));
+                    components.push_back(parameter.type);
+                }
+                add_expr(chart.requires_clause);
+                break;
+            }
+            case ChartSort::Multilevel:
+            {
+                const auto charts = reader.sequence(reader.get<symbolic::MultiChart>(index));
+                words.push_back(charts.size());
+                for (auto chart : charts)
+                    add_chart(chart, depth + 1);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        void add_eh(const symbolic::NoexceptSpecification& spec)
+        {
+            words.push_back(ifc::to_underlying(spec.sort));
+            if (not index_like::null(spec.words))
+                add_identity(ifc::to_underlying(spec.words));
+        }
+
+        // clang-format off
+        void add(const symbolic::FundamentalType& t)
+        {
+            words.push_back(ifc::to_underlying(t.basis));
+            words.push_back(ifc::to_underlying(t.precision));
+            words.push_back(ifc::to_underlying(t.sign));
+        }
+
+        void add(const symbolic::DesignatedType& t)      { add_hash(decl_hash(t.decl)); }
+        void add(const symbolic::SyntacticType& t)       { add_expr(t.expr); }
+        void add(const symbolic::PointerType& t)         { components.push_back(t.pointee); }
+        void add(const symbolic::LvalueReferenceType& t) { components.push_back(t.referee); }
+        void add(const symbolic::RvalueReferenceType& t) { components.push_back(t.referee); }
+        void add(const symbolic::UnalignedType& t)       { components.push_back(t.operand); }
+        void add(const symbolic::DecltypeType& t)        { add_identity(position(t.expression)); }
+        void add(const symbolic::TypenameType& t)        { add_expr(t.path); }
+        void add(const symbolic::SyntaxTreeType& t)      { add_identity(position(t.syntax)); }
+        // clang-format on
+
+        void add(const symbolic::TorType& t)
+        {
+            components.push_back(t.source);
+            add_eh(t.eh_spec);
+            words.push_back(ifc::to_underlying(t.convention));
+        }
+
+        void add(const symbolic::ExpansionType& t)
+        {
+            components.push_back(t.pack);
+            words.push_back(ifc::to_underlying(t.mode));
+        }
+
+        void add(const symbolic::PlaceholderType& t)
+        {
+            components.push_back(t.elaboration);
+            add_expr(t.constraint);
+            words.push_back(ifc::to_underlying(t.basis));
+        }
+
+        void add(const symbolic::PointerToMemberType& t)
+        {
+            components.push_back(t.scope);
+            components.push_back(t.type);
+        }
+
+        void add(const symbolic::TupleType& t)
+        {
+            const auto types = reader.sequence(t);
+            words.push_back(types.size());
+            components.insert(components.end(), types.begin(), types.end());
+        }
+
+        void add(const symbolic::ForallType& t)
+        {
+            components.push_back(t.subject);
+            add_chart(t.chart);
+        }
+
+        void add(const symbolic::FunctionType& t)
+        {
+            components.push_back(t.target);
+            components.push_back(t.source);
+            add_eh(t.eh_spec);
+            words.push_back(ifc::to_underlying(t.convention));
+            words.push_back(ifc::to_underlying(t.traits));
+        }
+
+        void add(const symbolic::MethodType& t)
+        {
+            components.push_back(t.target);
+            components.push_back(t.source);
+            components.push_back(t.class_type);
+            add_eh(t.eh_spec);
+            words.push_back(ifc::to_underlying(t.convention));
+            words.push_back(ifc::to_underlying(t.traits));
+        }
+
+        void add(const symbolic::ArrayType& t)
+        {
+            components.push_back(t.element);
+            add_expr(t.bound);
+        }
+
+        void add(const symbolic::QualifiedType& t)
+        {
+            components.push_back(t.unqualified_type);
+            words.push_back(ifc::to_underlying(t.qualifiers));
+        }
+
+        void add(const symbolic::BaseType& t)
+        {
+            components.push_back(t.type);
+            words.push_back(ifc::to_underlying(t.access));
+            words.push_back(ifc::to_underlying(t.traits));
+        }
+    };
+
+    CanonicalTypes::CanonicalTypes(Reader& reader)
+    {
+        // The null type comes first, with id 0.
+        Mix null;
+        null.add(word(Word::Null));
+        intern(null.get());
+
+        const auto& toc = reader.table_of_contents();
+        for (uint8_t s = 0; s < ids.size(); ++s)
+        {
+            const auto n = ifc::to_underlying(toc[TypeSort(s)].cardinality);
+            ids[s].assign(n, unvisited);
+            record_count += n;
+        }
+
+        Builder builder{reader, *this};
+        for (uint8_t s = 0; s < ids.size(); ++s)
+        {
+            for (uint32_t i = 0; i < ids[s].size(); ++i)
+                builder.resolve(index_like::make<TypeIndex>(TypeSort(s), i));
+        }
+    }
+
+    uint32_t CanonicalTypes::intern(const TypeHash& h)
+    {
+        auto [it, inserted] = by_hash.try_emplace(h, static_cast<uint32_t>(distinct.size()));
+        if (inserted)
+            distinct.push_back(h);
+        return it->second;
+    }
+
+    uint32_t CanonicalTypes::id(TypeIndex index) const
+    {
+        if (index_like::null(index))
+            return 0;
+        const auto& sort_ids = ids[ifc::to_underlying(index.sort())];
+        const auto n         = ifc::to_underlying(index.index());
+        IFCASSERT(n < sort_ids.size());
+        return sort_ids[n];
+    }
+
+    TypeHash CanonicalTypes::hash(TypeIndex index) const
+    {
+        return distinct[id(index)];
+    }
+} // namespace ifc::util
@@ -9,11 +9,9 @@ namespace ifc::util {
         if (index.sort() == ChartSort::None)
             return nullptr;
 
-        NodeKey key(index);
-        auto [it, inserted] = all_nodes.emplace(key, key);
-        if (inserted)
-            ifc::util::load(*this, it->second, index);
-        return &it->second;
+        Node& node = enqueue(index);
+        drain();
+        return &node;
     }
 
     void load(Loader& ctx, Node& node, ChartIndex index)
@@ -0,0 +1,388 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/columnar.hxx"
+
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+
+namespace ifc::util {
+    namespace {
+        using columnar::ColumnType;
+
+        constexpr uint32_t little_endian(uint32_t value)
+        {
+            if constexpr (std::endian::native == std::endian::big)
+                return std::byteswap(value);
+            return value;
+        }
+
+        // Append-only byte buffer in the layout of the columnar format.
+        class Encoder {
+        public:
+            void u32(uint32_t value)
+            {
+                value = little_endian(value);
+                raw(&value, sizeof value);
+            }
+
+            void u32s(const std::vector<uint32_t>& values)
+            {
+                if constexpr (std::endian::native == std::endian::little)
+                {
+                    raw(values.data(), values.size() * sizeof(uint32_t));
+                }
+                else
+                {
+                    for (auto value : values)
+                        u32(value);
+                }
+            }
+
+            void str(std::string_view s)
+            {
+                u32(static_cast<uint32_t>(s.size()));
+                raw(s.data(), s.size());
+                pad();
+            }
+
+            void raw(const void* data, std::size_t size)
+            {
+                const auto base = bytes.size();
+                bytes.resize(base + size);
+                if (size != 0)
+                    std::memcpy(bytes.data() + base, data, size);
+            }
+
+            void pad()
+            {
+                bytes.resize((bytes.size() + 3) & ~std::size_t{3});
+            }
+
+            std::vector<std::byte> bytes;
+        };
+
+        // A table being built row by row.  The columns are declared by the first row,
+        // and every row sets the same columns in the same order.
+        class Table {
+        public:
+            explicit Table(std::string_view name_) : name(name_) {}
+
+            void text(std::string_view column_name, std::string_view value)
+            {
+                auto& column = next_column(column_name, ColumnType::String);
+                auto [it, inserted] = column.codes.try_emplace(std::string{value}, static_cast<uint32_t>(column.entries.size()));
+                if (inserted)
+                    column.entries.push_back(&it->first);
+                column.values.push_back(it->second);
+            }
+
+            void number(std::string_view column_name, uint32_t value)
+            {
+                next_column(column_name, ColumnType::U32).values.push_back(value);
+            }
+
+            void end_row()
+            {
+                current = 0;
+                ++row_count;
+                if (++chunk_row_count == columnar::chunk_rows)
+                    flush_chunk();
+            }
+
+            std::vector<std::byte> finish()
+            {
+                if (chunk_row_count != 0)
+                    flush_chunk();
+
+                Encoder out;
+                out.str(name);
+                out.u32(row_count);
+                out.u32(static_cast<uint32_t>(columns.size()));
+                for (const auto& column : columns)
+                {
+                    out.str(column.name);
+                    out.u32(ifc::to_underlying(column.type));
+                }
+                out.u32(chunk_count);
+                out.raw(chunks.bytes.data(), chunks.bytes.size());
+                return std::move(out.bytes);
+            }
+
+        private:
+            struct Column {
+                std::string name;
+                ColumnType type;
+                std::vector<uint32_t> values; // values, or dictionary codes for strings
+                std::unordered_map<std::string, uint32_t> codes;
+                std::vector<const std::string*> entries; // dictionary, in code order
+            };
+
+            Column& next_column(std::string_view column_name, ColumnType type)
+            {
+                if (current == columns.size())
+                {
+                    IFCASSERT(row_count == 0);
+                    columns.push_back({std::string{column_name}, type, {}, {}, {}});
+                }
+                return columns[current++];
+            }
+
+            void flush_chunk()
+            {
+                chunks.u32(chunk_row_count);
+                for (auto& column : columns)
+                {
+                    if (column.type == ColumnType::String)
+                    {
+                        chunks.u32(static_cast<uint32_t>(column.entries.size()));
+                        uint32_t offset = 0;
+                        chunks.u32(offset);
+                        for (const auto* entry : column.entries)
+                            chunks.u32(offset += static_cast<uint32_t>(entry->size()));
+                        for (const auto* entry : column.entries)
+                            chunks.raw(entry->data(), entry->size());
+                        chunks.pad();
+                        column.entries.clear();
+                        column.codes.clear();
+                    }
+                    chunks.u32s(column.values);
+                    column.values.clear();
+                }
+                chunk_row_count = 0;
+                ++chunk_count;
+            }
+
+            std::string name;
+            std::vector<Column> columns;
+            std::size_t current      = 0;
+            uint32_t row_count       = 0;
+            uint32_t chunk_row_count = 0;
+            uint32_t chunk_count     = 0;
+            Encoder chunks;
+        };
+
+        // clang-format off
+        template <class T> concept HasAccess = requires(T x) { x.access; };
+        template <class T> concept HasBasicSpec = requires(T x) { x.basic_spec; };
+        template <class T> concept HasIdentity = requires(T x) { x.identity; };
+        template <class T> concept HasLocus = requires(T x) { { x.locus } -> std::convertible_to<symbolic::SourceLocation>; };
+        template <class T> concept HasScopeSpec = requires(T x) { x.scope_spec; };
+        template <class T> concept HasTraits = requires(T x) { x.traits; };
+        template <class T> concept HasObjectSpec = requires(T x) { x.obj_spec; };
+        template <class T> concept HasProperties = requires(T x) { x.properties; };
+        template <class T> concept HasType = requires(T x) { { x.type } -> std::convertible_to<TypeIndex>; };
+        template <class T> concept HasCallingConvention = requires(T x) { x.convention; };
+        template <class T> concept HasHomeScope = requires(T x) { { x.home_scope } -> std::convertible_to<DeclIndex>; };
+        // clang-format on
+
+        template<typename T>
+        void decl_row(Loader& ctx, Table& table, const T& val)
+        {
+            if constexpr (HasIdentity<T>)
+            {
+                table.text("name", ctx.ref(val.identity));
+                table.number("line", ifc::to_underlying(val.identity.locus.line));
+                table.number("column", ifc::to_underlying(val.identity.locus.column));
+            }
+            else if constexpr (HasLocus<T>)
+            {
+                table.number("line", ifc::to_underlying(val.locus.line));
+                table.number("column", ifc::to_underlying(val.locus.column));
+            }
+
+            if constexpr (HasType<T>)
+                table.text("type", ctx.ref(val.type));
+
+            if constexpr (HasHomeScope<T>)
+            {
+                char buf[format_buffer_size];
+                const auto end = null(val.home_scope) ? buf : format_to(buf, val.home_scope);
+                table.text("home-scope", {buf, end});
+            }
+
+            if constexpr (HasAccess<T>)
+                table.text("access", to_string(val.access));
+
+            if constexpr (HasBasicSpec<T>)
+                table.text("basic-specifiers", to_string(val.basic_spec));
+
+            if constexpr (HasScopeSpec<T>)
+                table.text("scope-specifiers", to_string(val.scope_spec));
+
+            if constexpr (HasObjectSpec<T>)
+                table.text("object-specifiers", to_string(val.obj_spec));
+
+            if constexpr (HasTraits<T>)
+                table.text("traits", to_string(val.traits));
+
+            if constexpr (HasProperties<T>)
+                table.text("reachable-properties", to_string(val.properties));
+
+            if constexpr (HasCallingConvention<T>)
+                table.text("calling-convention", to_string(val.convention));
+        }
+
+        // True if the partition of T in the IFC has entries of the size this reader expects.
+        template<typename T>
+        bool has_expected_layout(const Reader& reader)
+        {
+            const auto& summary = reader.table_of_contents()[T::algebra_sort];
+            return summary.empty() or ifc::to_underlying(summary.entry_size) == sizeof(T);
+        }
+
+        template<typename T>
+        std::vector<std::byte> decl_table(Loader& ctx)
+        {
+            Table table{sort_name(T::algebra_sort)};
+            if (has_expected_layout<T>(ctx.reader))
+            {
+                for (const auto& decl : ctx.reader.partition<T>())
+                {
+                    decl_row(ctx, table, decl);
+                    table.end_row();
+                }
+            }
+            return table.finish();
+        }
+
+        // A type table has a single column with the type in the form used by the DOM, e.g. "int*".
+        template<typename T>
+        std::vector<std::byte> type_table(Loader& ctx)
+        {
+            Table table{sort_name(T::algebra_sort)};
+            if (has_expected_layout<T>(ctx.reader))
+            {
+                const auto count = static_cast<uint32_t>(ctx.reader.partition<T>().size());
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    table.text("text", ctx.ref(TypeIndex{T::algebra_sort, i}));
+                    table.end_row();
+                }
+            }
+            return table.finish();
+        }
+
+        using TableBuilder = std::vector<std::byte> (*)(Loader&);
+
+        // clang-format off
+        constexpr TableBuilder table_builders[] = {
+            &decl_table<symbolic::EnumeratorDecl>,
+            &decl_table<symbolic::VariableDecl>,
+            &decl_table<symbolic::ParameterDecl>,
+            &decl_table<symbolic::FieldDecl>,
+            &decl_table<symbolic::BitfieldDecl>,
+            &decl_table<symbolic::ScopeDecl>,
+            &decl_table<symbolic::EnumerationDecl>,
+            &decl_table<symbolic::AliasDecl>,
+            &decl_table<symbolic::TemploidDecl>,
+            &decl_table<symbolic::TemplateDecl>,
+            &decl_table<symbolic::PartialSpecializationDecl>,
+            &decl_table<symbolic::SpecializationDecl>,
+            &decl_table<symbolic::DefaultArgumentDecl>,
+            &decl_table<symbolic::ConceptDecl>,
+            &decl_table<symbolic::FunctionDecl>,
+            &decl_table<symbolic::NonStaticMemberFunctionDecl>,
+            &decl_table<symbolic::ConstructorDecl>,
+            &decl_table<symbolic::InheritedConstructorDecl>,
+            &decl_table<symbolic::DestructorDecl>,
+            &decl_table<symbolic::UsingDecl>,
+            &decl_table<symbolic::DeductionGuideDecl>,
+            &decl_table<symbolic::IntrinsicDecl>,
+
+            &type_table<symbolic::FundamentalType>,
+            &type_table<symbolic::DesignatedType>,
+            &type_table<symbolic::TorType>,
+            &type_table<symbolic::SyntacticType>,
+            &type_table<symbolic::ExpansionType>,
+            &type_table<symbolic::PointerType>,
+            &type_table<symbolic::PointerToMemberType>,
+            &type_table<symbolic::LvalueReferenceType>,
+            &type_table<symbolic::RvalueReferenceType>,
+            &type_table<symbolic::FunctionType>,
+            &type_table<symbolic::MethodType>,
+            &type_table<symbolic::ArrayType>,
+            &type_table<symbolic::TypenameType>,
+            &type_table<symbolic::QualifiedType>,
+            &type_table<symbolic::BaseType>,
+            &type_table<symbolic::DecltypeType>,
+            &type_table<symbolic::PlaceholderType>,
+            &type_table<symbolic::TupleType>,
+            &type_table<symbolic::ForallType>,
+            &type_table<symbolic::UnalignedType>,
+            &type_table<symbolic::SyntaxTreeType>,
+        };
+        // clang-format on
+    } // namespace
+
+    void write_columnar(Reader& reader, std::ostream& out, unsigned jobs)
+    {
+        constexpr auto count = std::size(table_builders);
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+        jobs = std::min<unsigned>(jobs, count);
+
+        // Tables are claimed by the workers in order, and handed back through `tables`.
+        std::vector<std::vector<std::byte>> tables(count);
+        std::vector<bool> done(count);
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::atomic<std::size_t> next{0};
+
+        auto work = [&] {
+            Loader ctx{reader};
+            for (std::size_t i; (i = next++) < count;)
+            {
+                std::vector<std::byte> bytes;
+                std::exception_ptr failure;
+                try
+                {
+                    bytes = table_builders[i](ctx);
+                }
+                catch (...)
+                {
+                    failure = std::current_exception();
+                }
+
+                std::lock_guard lock{mutex};
+                tables[i] = std::move(bytes);
+                done[i]   = true;
+                if (failure and not error)
+                    error = failure;
+                ready.notify_all();
+            }
+        };
+
+        std::vector<std::jthread> workers;
+        for (unsigned i = 0; i < jobs; ++i)
+            workers.emplace_back(work);
+
+        const uint32_t header[] = {little_endian(columnar::magic), little_endian(columnar::version),
+                                   little_endian(static_cast<uint32_t>(count))};
+        out.write(reinterpret_cast<const char*>(header), sizeof header);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::vector<std::byte> bytes;
+            {
+                std::unique_lock lock{mutex};
+                ready.wait(lock, [&] { return done[i]; });
+                if (error)
+                    break;
+                bytes = std::move(tables[i]);
+            }
+            out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+
+        workers.clear();
+        if (error)
+            std::rethrow_exception(error);
+    }
+} // namespace ifc::util
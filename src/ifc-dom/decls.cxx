@@ -10,7 +10,7 @@ namespace ifc::util {
         if (auto* scope = ctx.reader.try_get(index))
         {
             const auto seq = ctx.reader.sequence(*scope);
-            node.id        = to_string(index);
+            append_to(node.id, index);
             node.children.reserve(seq.size());
 
             for (auto& decl : seq)
@@ -58,7 +58,7 @@ namespace ifc::util {
     {
         if (auto* specializations = ctx.reader.try_find<symbolic::trait::Specializations>(decl_index))
             for (auto& decl : ctx.reader.sequence(specializations->trait))
-                ctx.referenced_nodes.insert(decl.index);
+                ctx.reference(decl.index);
     }
 
     // clang-format off
@@ -402,7 +402,7 @@ namespace ifc::util {
             return;
         }
 
-        node.id = to_string(index);
+        append_to(node.id, index);
         DeclLoader loader{ctx, node};
         ctx.reader.visit_with_index(index, loader);
     }
@@ -370,12 +370,12 @@ namespace ifc::util {
             {
                 if (not result.empty())
                     result.push_back(',');
-                result.append(ctx.ref(item));
+                ctx.append_ref(result, item);
             }
         }
         else if (not null(index))
         {
-            result.append(ctx.ref(index));
+            ctx.append_ref(result, index);
         }
         if (delimiters.size() > 0)
             result.insert(0, 1, delimiters[0]);
@@ -387,55 +387,66 @@ namespace ifc::util {
     // Try to produce a short string for an expression, if possible.
 
     namespace {
+        // Appends the short string for an expression to `out`, which is the render buffer of the loader.
+        // Nothing is appended if the expression has no short form.
         struct ExpxTranslator {
             Loader& ctx;
+            std::string& out;
 
-            std::string operator()(const symbolic::EmptyExpr&)
+            void operator()(const symbolic::EmptyExpr&)
             {
-                return "empty-expr";
+                out.append("empty-expr");
             }
 
-            std::string operator()(const symbolic::NullptrExpr&)
+            void operator()(const symbolic::NullptrExpr&)
             {
-                return "nullptr";
+                out.append("nullptr");
             }
 
-            std::string operator()(const symbolic::ThisExpr&)
+            void operator()(const symbolic::ThisExpr&)
             {
-                return "this";
+                out.append("this");
             }
 
-            std::string operator()(const symbolic::LiteralExpr& expr)
+            void operator()(const symbolic::LiteralExpr& expr)
             {
-                return to_string(ctx, expr.value);
+                out.append(to_string(ctx, expr.value));
             }
 
-            std::string operator()(const symbolic::TypeExpr& expr)
+            void operator()(const symbolic::TypeExpr& expr)
             {
-                return ctx.ref(expr.denotation);
+                ctx.append_ref(out, expr.denotation);
             }
 
-            std::string operator()(const symbolic::NamedDeclExpr& expr)
+            void operator()(const symbolic::NamedDeclExpr& expr)
             {
-                return std::string("decl-ref(") + ctx.ref(expr.decl) + ")";
+                out.append("decl-ref(");
+                ctx.append_ref(out, expr.decl);
+                out.push_back(')');
             }
 
             template<typename T>
-            std::string operator()(const T&)
-            {
-                return "";
-            }
+            void operator()(const T&)
+            {}
         };
 
     } // namespace
 
-    std::string get_string_if_possible(Loader& ctx, ExprIndex expr)
+    std::string_view short_string(Loader& ctx, ExprIndex expr)
     {
         if (null(expr))
             return "no-expr";
-        if (expr.sort() == ExprSort::VendorExtension)
-            return "expr-vendor-" + std::to_string(ifc::to_underlying(expr.index()));
-        return ctx.reader.visit(expr, ExpxTranslator{ctx});
+        return ctx.render(expr, [&](std::string& out) {
+            if (expr.sort() == ExprSort::VendorExtension)
+                out.append("expr-vendor-").append(std::to_string(ifc::to_underlying(expr.index())));
+            else
+                ctx.reader.visit(expr, ExpxTranslator{ctx, out});
+        });
+    }
+
+    std::string get_string_if_possible(Loader& ctx, ExprIndex expr)
+    {
+        return std::string(short_string(ctx, expr));
     }
 
 } // namespace ifc::util
@@ -0,0 +1,184 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/filter.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace ifc::util {
+    namespace fs = std::filesystem;
+
+    namespace {
+        // First bytes of a saved cache.
+        constexpr char cache_signature[16] = "ifc-filters 1";
+
+        constexpr std::size_t block_words    = 8;
+        constexpr std::size_t bits_per_entry = 10;
+
+        // One odd multiplier per word of a block, as in the split-block filters of Parquet.
+        constexpr uint32_t salts[block_words] = {0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+                                                 0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U};
+
+        bool is_identifier(std::string_view str)
+        {
+            return not str.empty() and std::ranges::all_of(str, [](char c) {
+                return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9') or c == '_';
+            });
+        }
+
+        // 64-bit FNV-1a, then the finalizer of MurmurHash3: the filters are saved, so the hash does
+        // not depend on the platform, nor on the run.
+        uint64_t hash_of(std::string_view str)
+        {
+            uint64_t h = 0xCBF29CE484222325;
+            for (auto c : str)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 0x100000001B3;
+            }
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCD;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // The block of the hash, and the bit of each of its words.
+        std::size_t block_of(uint64_t hash, std::size_t blocks)
+        {
+            return static_cast<std::size_t>(((hash >> 32) * blocks) >> 32);
+        }
+
+        uint32_t bit_of(uint64_t hash, std::size_t word)
+        {
+            return uint32_t{1} << ((static_cast<uint32_t>(hash) * salts[word]) >> 27);
+        }
+    } // namespace
+
+    IdentifierFilter::IdentifierFilter(std::string_view strings)
+    {
+        std::vector<uint64_t> hashes;
+        for (std::size_t start = 0; start < strings.size();)
+        {
+            auto end = strings.find('\0', start);
+            if (end == std::string_view::npos)
+                end = strings.size();
+            if (const auto str = strings.substr(start, end - start); is_identifier(str))
+                hashes.push_back(hash_of(str));
+            start = end + 1;
+        }
+        std::ranges::sort(hashes);
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+        const auto blocks = std::max<std::size_t>(1, (hashes.size() * bits_per_entry + 255) / 256);
+        bits.resize(blocks * block_words);
+        for (auto hash : hashes)
+        {
+            auto* block = &bits[block_of(hash, blocks) * block_words];
+            for (std::size_t i = 0; i < block_words; ++i)
+                block[i] |= bit_of(hash, i);
+        }
+    }
+
+    IdentifierFilter::IdentifierFilter(std::vector<uint32_t> words) : bits(std::move(words))
+    {
+        if (bits.empty() or bits.size() % block_words != 0)
+            throw "invalid identifier filter";
+    }
+
+    bool IdentifierFilter::may_contain(std::string_view identifier) const
+    {
+        const auto hash   = hash_of(identifier);
+        const auto* block = &bits[block_of(hash, bits.size() / block_words) * block_words];
+        // No early exit: the loop is short and vectorizes.
+        bool present = true;
+        for (std::size_t i = 0; i < block_words; ++i)
+            present &= (block[i] & bit_of(hash, i)) != 0;
+        return present;
+    }
+
+    FilterCache::FilterCache(fs::path file_) : file(std::move(file_))
+    {
+        // Content hash, number of words, then the words of each filter.
+        std::ifstream stream{file, std::ios_base::binary};
+        char signature[sizeof cache_signature];
+        if (not stream.read(signature, sizeof signature)
+            or std::memcmp(signature, cache_signature, sizeof signature) != 0)
+            return;
+        std::error_code ec;
+        const auto size = fs::file_size(file, ec);
+        if (ec)
+            return;
+        SHA256Hash hash;
+        uint32_t count = 0;
+        while (stream.read(reinterpret_cast<char*>(&hash), sizeof hash)
+               and stream.read(reinterpret_cast<char*>(&count), sizeof count))
+        {
+            // The count of a damaged cache may be anything: it is checked against what is left of
+            // the file before anything is allocated.
+            const auto position = static_cast<std::uintmax_t>(stream.tellg());
+            const auto left     = size > position ? size - position : 0;
+            if (count == 0 or count % block_words != 0 or count > left / sizeof(uint32_t))
+            {
+                filters.clear();
+                return;
+            }
+            std::vector<uint32_t> words(count);
+            if (not stream.read(reinterpret_cast<char*>(words.data()),
+                                static_cast<std::streamsize>(count * sizeof(uint32_t))))
+            {
+                filters.clear();
+                return;
+            }
+            filters.insert_or_assign(hash.value, Entry{IdentifierFilter{std::move(words)}, false});
+        }
+    }
+
+    std::optional<bool> FilterCache::may_contain(const SHA256Hash& content_hash, std::string_view identifier) const
+    {
+        std::lock_guard lock{mutex};
+        auto it = filters.find(content_hash.value);
+        if (it == filters.end())
+            return std::nullopt;
+        it->second.used = true;
+        return it->second.filter.may_contain(identifier);
+    }
+
+    void FilterCache::insert(const SHA256Hash& content_hash, IdentifierFilter filter)
+    {
+        std::lock_guard lock{mutex};
+        filters.insert_or_assign(content_hash.value, Entry{std::move(filter), true});
+        changed = true;
+    }
+
+    void FilterCache::save() const
+    {
+        std::lock_guard lock{mutex};
+        if (not changed)
+            return;
+        // Write aside, then replace, so that a concurrent reader never sees half a cache.
+        auto temporary = file;
+        temporary += ".tmp";
+        {
+            std::ofstream stream{temporary, std::ios_base::binary | std::ios_base::trunc};
+            stream.write(cache_signature, sizeof cache_signature);
+            for (const auto& [hash, entry] : filters)
+            {
+                if (not entry.used)
+                    continue;
+                const auto& words  = entry.filter.words();
+                const auto count   = static_cast<uint32_t>(words.size());
+                stream.write(reinterpret_cast<const char*>(hash.data()), sizeof hash);
+                stream.write(reinterpret_cast<const char*>(&count), sizeof count);
+                stream.write(reinterpret_cast<const char*>(words.data()),
+                             static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+            }
+            if (not stream.flush())
+                throw "couldn't write the filter cache";
+        }
+        fs::rename(temporary, file);
+    }
+} // namespace ifc::util
@@ -0,0 +1,368 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/grep.hxx"
+#include "ifc/dom/node.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace ifc::util {
+    namespace fs = std::filesystem;
+
+    namespace {
+        bool is_identifier_char(char c)
+        {
+            return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9') or c == '_';
+        }
+
+        // The longest run of identifier characters that any match of the regular pattern contains.
+        std::string required_text(std::string_view pattern)
+        {
+            // Alternatives and groups can make any part of the pattern optional.  The names of
+            // operators are not in the string table as such.
+            if (pattern.find_first_of("|()") != std::string_view::npos
+                or pattern.find("operator") != std::string_view::npos)
+                return {};
+
+            std::string best;
+            std::string run;
+            auto flush = [&] {
+                if (run.size() > best.size())
+                    best = run;
+                run.clear();
+            };
+            for (std::size_t i = 0; i < pattern.size(); ++i)
+            {
+                const char c = pattern[i];
+                if (c == '\\')
+                {
+                    // An escape stands for a class of characters, or for punctuation.
+                    flush();
+                    ++i;
+                }
+                else if (c == '[')
+                {
+                    flush();
+                    auto j = i + 1;
+                    if (j < pattern.size() and pattern[j] == '^')
+                        ++j;
+                    if (j < pattern.size() and pattern[j] == ']')
+                        ++j;
+                    for (; j < pattern.size() and pattern[j] != ']'; ++j)
+                    {
+                        if (pattern[j] == '\\')
+                            ++j;
+                    }
+                    i = j;
+                }
+                else if (c == '?' or c == '*' or c == '{')
+                {
+                    // The character before is optional.
+                    if (not run.empty())
+                        run.pop_back();
+                    flush();
+                    if (c == '{')
+                        i = std::min(pattern.find('}', i), pattern.size());
+                }
+                else if (is_identifier_char(c))
+                {
+                    run.push_back(c);
+                }
+                else
+                {
+                    flush();
+                }
+            }
+            flush();
+            return best;
+        }
+
+        // The offsets in the string table of the strings equal to `text`.
+        std::vector<uint32_t> occurrences(std::string_view strings, std::string_view text)
+        {
+            std::vector<uint32_t> offsets;
+            std::string delimited{'\0'};
+            delimited.append(text).push_back('\0');
+            if (strings.starts_with(std::string_view{delimited}.substr(1)))
+                offsets.push_back(0);
+            for (auto pos = strings.find(delimited); pos != std::string_view::npos;
+                 pos      = strings.find(delimited, pos + delimited.size() - 1))
+                offsets.push_back(static_cast<uint32_t>(pos + 1));
+            return offsets;
+        }
+
+        std::optional<Header> read_header(std::istream& stream)
+        {
+            char signature[sizeof InterfaceSignature];
+            Header header;
+            if (not stream.read(signature, sizeof signature)
+                or std::memcmp(signature, InterfaceSignature, sizeof signature) != 0
+                or not stream.read(reinterpret_cast<char*>(&header), sizeof header))
+                return std::nullopt;
+            return header;
+        }
+
+        // The string table of the IFC file, read without the rest of the file; nothing if the
+        // header places it beyond the end of the file, which is `size` bytes long.
+        std::optional<std::string> read_strings(std::istream& stream, const Header& header, std::uintmax_t size)
+        {
+            const std::uintmax_t offset = ifc::to_underlying(header.string_table_bytes);
+            const std::uintmax_t length = ifc::to_underlying(header.string_table_size);
+            if (offset > size or length > size - offset)
+                return std::nullopt;
+            std::string strings(length, '\0');
+            if (not stream.seekg(ifc::to_underlying(header.string_table_bytes))
+                or not stream.read(strings.data(), static_cast<std::streamsize>(strings.size())))
+                return std::nullopt;
+            return strings;
+        }
+
+        std::string location_of(const Reader& reader, const symbolic::SourceLocation& locus)
+        {
+            const auto& lines = reader.table_of_contents().lines;
+            if (ifc::to_underlying(locus.line) >= ifc::to_underlying(lines.cardinality))
+                return "?";
+            const auto& where = reader.get(locus.line);
+            std::string file  = "?";
+            if (not index_like::null(where.file) and where.file.sort() == NameSort::Identifier)
+                file = reader.get(TextOffset(ifc::to_underlying(where.file.index())));
+            else if (not index_like::null(where.file) and where.file.sort() == NameSort::SourceFile)
+                file = reader.get(reader.get<symbolic::SourceFileName>(where.file).name);
+            return file + ":" + std::to_string(ifc::to_underlying(where.line)) + ":"
+                   + std::to_string(ifc::to_underlying(locus.column));
+        }
+
+        // Names of the declarations of one file, qualified by the names of their enclosing
+        // declarations.
+        class Names {
+        public:
+            explicit Names(Reader& reader) : ctx(reader) {}
+
+            const std::string& qualified_name(DeclIndex index)
+            {
+                auto [it, inserted] = names.try_emplace(index);
+                if (not inserted)
+                    return it->second;
+
+                DeclIndex home{};
+                auto name = ctx.reader.visit_with_index(index, [&](DeclIndex, const auto& decl) {
+                    if constexpr (requires { decl.home_scope; })
+                        home = decl.home_scope;
+                    if constexpr (requires { decl.identity; })
+                        return ctx.ref(decl.identity);
+                    else
+                        return std::string{"("} + sort_name(index.sort()) + ")";
+                });
+                // The placeholder is the name seen by a malformed cycle of enclosing declarations.
+                if (not index_like::null(home))
+                {
+                    it->second = "(cycle)";
+                    name       = qualified_name(home) + "::" + name;
+                }
+                it->second = std::move(name);
+                return it->second;
+            }
+
+            Loader& loader()
+            {
+                return ctx;
+            }
+
+        private:
+            Loader ctx;
+            std::map<DeclIndex, std::string> names;
+        };
+
+        bool is_among(const std::vector<uint32_t>& offsets, TextOffset offset)
+        {
+            return std::ranges::find(offsets, ifc::to_underlying(offset)) != offsets.end();
+        }
+
+        template<typename T>
+        bool named_among(const std::vector<uint32_t>& offsets, const symbolic::Identity<T>& identity)
+        {
+            if constexpr (std::same_as<T, NameIndex>)
+                return not index_like::null(identity.name) and identity.name.sort() == NameSort::Identifier
+                       and is_among(offsets, TextOffset(ifc::to_underlying(identity.name.index())));
+            else
+                return is_among(offsets, identity.name);
+        }
+
+        // Call f(index, decl) on each declaration that is a member of a scope: parameters and the
+        // like are left out.
+        template<typename F>
+        void for_each_member(Reader& reader, F f)
+        {
+            for (uint8_t s = 0; s < ifc::to_underlying(DeclSort::Count); ++s)
+            {
+                const auto sort        = DeclSort(s);
+                const auto cardinality = ifc::to_underlying(reader.table_of_contents()[sort].cardinality);
+                for (uint32_t i = 0; i < cardinality; ++i)
+                {
+                    reader.visit_with_index(index_like::make<DeclIndex>(sort, i), [&](DeclIndex index, const auto& decl) {
+                        if constexpr (requires { decl.identity; decl.home_scope; })
+                            f(index, decl);
+                    });
+                }
+            }
+        }
+
+        std::vector<SymbolMatch> find_matches(Reader& reader, const SymbolPattern& pattern,
+                                              const std::vector<uint32_t>& leaves)
+        {
+            std::vector<SymbolMatch> matches;
+            Names names{reader};
+            for_each_member(reader, [&](DeclIndex index, const auto& decl) {
+                if (pattern.exact() and not named_among(leaves, decl.identity))
+                    return;
+                const auto& name = names.qualified_name(index);
+                if (pattern.matches(name))
+                    matches.push_back({name, sort_name(index.sort()), location_of(reader, decl.identity.locus)});
+            });
+            return matches;
+        }
+    } // namespace
+
+    SymbolPattern::SymbolPattern(std::string_view pattern, bool regular_) : text(pattern), regular(regular_)
+    {
+        if (regular)
+        {
+            expression.emplace(text, std::regex::ECMAScript | std::regex::optimize);
+            needle = required_text(text);
+        }
+        else
+        {
+            const auto last = text.rfind("::");
+            needle          = last == std::string::npos ? text : text.substr(last + 2);
+            if (not std::ranges::all_of(needle, is_identifier_char))
+                needle.clear();
+        }
+    }
+
+    bool SymbolPattern::may_occur(std::string_view strings) const
+    {
+        if (needle.empty())
+            return true;
+        // The standard search looks for the first character with memchr, which is vectorized.
+        if (regular)
+            return strings.find(needle) != std::string_view::npos;
+        return not occurrences(strings, needle).empty();
+    }
+
+    bool SymbolPattern::matches(std::string_view qualified_name) const
+    {
+        if (regular)
+            return std::regex_search(qualified_name.begin(), qualified_name.end(), *expression);
+        std::string_view suffix{text};
+        if (suffix.starts_with("::"))
+            return qualified_name == suffix.substr(2);
+        if (not qualified_name.ends_with(suffix))
+            return false;
+        const auto rest = qualified_name.substr(0, qualified_name.size() - suffix.size());
+        return rest.empty() or rest.ends_with("::");
+    }
+
+    std::vector<DeclaredName> declared_names(Reader& reader)
+    {
+        std::vector<DeclaredName> result;
+        Names names{reader};
+        Loader& ctx = names.loader();
+        for_each_member(reader, [&](DeclIndex index, const auto& decl) {
+            result.push_back({index, names.qualified_name(index), ctx.ref(decl.identity)});
+        });
+        return result;
+    }
+
+    FileMatches grep_ifc(const fs::path& path, const SymbolPattern& pattern, FilterCache* cache)
+    {
+        FileMatches result;
+        result.path = path;
+        std::ifstream stream{path, std::ios_base::binary};
+        const auto header = read_header(stream);
+        if (not header)
+            return result;
+
+        // The filter of the file, if cached, may tell from the header alone that the file does
+        // not hold the last component of a plain pattern.
+        std::optional<bool> filtered;
+        if (cache != nullptr)
+            filtered = cache->may_contain(header->content_hash, pattern.required());
+        if (pattern.exact() and filtered and not *filtered)
+            return result;
+
+        std::error_code ec;
+        const auto size    = fs::file_size(path, ec);
+        const auto strings = ec ? std::nullopt : read_strings(stream, *header, size);
+        if (not strings)
+        {
+            result.failed = true;
+            return result;
+        }
+        if (cache != nullptr and not filtered)
+            cache->insert(header->content_hash, IdentifierFilter{*strings});
+        if (not pattern.may_occur(*strings))
+            return result;
+
+        // The declarations named by the required text, if the pattern is plain, are found by their
+        // offsets in the string table without looking at the strings again.
+        std::vector<uint32_t> leaves;
+        if (pattern.exact())
+            leaves = occurrences(*strings, pattern.required());
+
+        try
+        {
+            const auto module = load_module(path);
+            result.module     = module->name;
+            result.matches    = find_matches(module->reader(), pattern, leaves);
+        }
+        catch (...)
+        {
+            result.failed = true;
+        }
+        return result;
+    }
+
+    std::vector<FileMatches> grep_ifcs(const std::vector<fs::path>& paths, const SymbolPattern& pattern,
+                                       unsigned jobs, FilterCache* cache)
+    {
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+
+        std::vector<FileMatches> results(paths.size());
+        std::atomic<std::size_t> next{0};
+        std::mutex mutex;
+        std::exception_ptr error;
+        auto work = [&] {
+            try
+            {
+                for (auto i = next++; i < paths.size(); i = next++)
+                    results[i] = grep_ifc(paths[i], pattern, cache);
+            }
+            catch (...)
+            {
+                std::lock_guard lock{mutex};
+                if (not error)
+                    error = std::current_exception();
+                next = paths.size();
+            }
+        };
+        {
+            std::vector<std::jthread> workers;
+            const auto n = std::min<std::size_t>(jobs, paths.size());
+            for (std::size_t i = 0; i < n; ++i)
+                workers.emplace_back(work);
+        }
+        if (error)
+            std::rethrow_exception(error);
+
+        std::erase_if(results, [](const FileMatches& file) { return file.matches.empty() and not file.failed; });
+        return results;
+    }
+} // namespace ifc::util
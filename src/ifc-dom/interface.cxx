@@ -0,0 +1,466 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/interface.hxx"
+#include "ifc/reader.hxx"
+#include "ifc/util.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ifc::util {
+    namespace {
+        // 64-bit FNV-1a: the hashes do not depend on the platform, nor on the run.
+        class Fnv {
+        public:
+            void add(std::string_view bytes)
+            {
+                for (auto c : bytes)
+                {
+                    value ^= static_cast<unsigned char>(c);
+                    value *= prime;
+                }
+                // Separate the strings, so that ("ab", "c") and ("a", "bc") differ.
+                value ^= 0xFF;
+                value *= prime;
+            }
+
+            // The bytes of the integer are taken least significant first, whatever the byte order.
+            void add(uint64_t n)
+            {
+                char bytes[sizeof n];
+                for (std::size_t i = 0; i < sizeof n; ++i)
+                    bytes[i] = static_cast<char>(n >> (8 * i));
+                add(std::string_view{bytes, sizeof n});
+            }
+
+            uint64_t get() const
+            {
+                return value;
+            }
+
+        private:
+            static constexpr uint64_t prime = 0x100000001B3;
+            uint64_t value                  = 0xCBF29CE484222325;
+        };
+
+        bool is_namespace(Reader& reader, const symbolic::ScopeDecl& decl)
+        {
+            return decl.type.sort() == TypeSort::Fundamental
+                   and reader.get<symbolic::FundamentalType>(decl.type).basis == symbolic::TypeBasis::Namespace;
+        }
+
+        bool is_exported(Reader& reader, DeclIndex index)
+        {
+            return reader.visit_with_index(index, [](DeclIndex, const auto& decl) {
+                if constexpr (requires { decl.basic_spec; })
+                    return not ifc::implies(decl.basic_spec, BasicSpecifiers::NonExported);
+                else
+                    return true;
+            });
+        }
+
+        // This predicate holds for the properties whose value is a source location, e.g. that
+        // of the statements of an inline function body.
+        bool is_location(std::string_view property)
+        {
+            return property == "locus";
+        }
+
+        // Structural hashes of the nodes of one loader, see interface.hxx.
+        class Hasher {
+        public:
+            explicit Hasher(Loader& ctx_) : ctx(ctx_) {}
+
+            // Name of the declaration, qualified by the names of its enclosing declarations.
+            const std::string& qualified_name(DeclIndex index)
+            {
+                auto [it, inserted] = names.try_emplace(NodeKey{index});
+                if (not inserted)
+                    return it->second;
+
+                DeclIndex home{};
+                auto name = ctx.reader.visit_with_index(index, [&](DeclIndex, const auto& decl) {
+                    if constexpr (requires { decl.home_scope; })
+                        home = decl.home_scope;
+                    if constexpr (requires { decl.identity; })
+                        return ctx.ref(decl.identity);
+                    else
+                        return std::string{"("} + sort_name(index.sort()) + ")";
+                });
+                // Map elements do not move, so `it` survives the insertions made for the enclosing
+                // declarations; the placeholder is the name seen by a malformed cycle of them.
+                if (not index_like::null(home))
+                {
+                    it->second = "(cycle)";
+                    name = qualified_name(home) + "::" + name;
+                }
+                it->second = std::move(name);
+                return it->second;
+            }
+
+            uint64_t hash(const Node& root)
+            {
+                // Post-order walk with an explicit stack: expressions can nest deeply.
+                struct Step {
+                    const Node* node;
+                    bool expanded;
+                };
+                // Each dependency of a node, in order: its children, then what it refers to other
+                // than declarations.
+                auto for_each_dependency = [&](const Node* node, auto f) {
+                    for (const auto* child : node->children)
+                        f(child);
+                    for (auto key : node->references)
+                        if (key.kind() != SortKind::Decl)
+                            f(&ctx.get(key));
+                };
+                std::vector<Step> work{{&root, false}};
+                while (not work.empty())
+                {
+                    auto [node, expanded] = work.back();
+                    if (hashes.contains(node))
+                    {
+                        work.pop_back();
+                        continue;
+                    }
+                    if (not expanded)
+                    {
+                        work.back().expanded = true;
+                        open.insert(node);
+                        // A node being hashed is a dependency only through a cycle, which the
+                        // hash of the dependent node then ignores.
+                        for_each_dependency(node, [&](const Node* dependency) {
+                            if (open.contains(dependency))
+                                in_cycle.insert(node);
+                            else if (not hashes.contains(dependency))
+                                work.push_back({dependency, false});
+                        });
+                        continue;
+                    }
+                    work.pop_back();
+                    open.erase(node);
+                    for_each_dependency(node, [&](const Node* dependency) {
+                        if (in_cycle.contains(dependency))
+                            in_cycle.insert(node);
+                    });
+                    hashes.emplace(node, combine(*node));
+                }
+                const auto result = hashes.at(&root);
+
+                // The hash of a node that reaches a cycle depends on where the walk entered the
+                // cycle, hence on the root: it is not kept for the next one, so that the hash of
+                // an entity does not depend on the entities hashed before it.
+                for (const auto* node : in_cycle)
+                    hashes.erase(node);
+                in_cycle.clear();
+                return result;
+            }
+
+        private:
+            uint64_t hash_of(const Node& node) const
+            {
+                auto it = hashes.find(&node);
+                return it != hashes.end() ? it->second : 0;
+            }
+
+            uint64_t combine(const Node& node)
+            {
+                Fnv fnv;
+                fnv.add(uint64_t{ifc::to_underlying(node.key.kind())} << 16 | node.key.sort());
+                for (const auto& [name, value] : node.props)
+                {
+                    // The home scope is an index, and implied by the qualified name; source locations
+                    // are not part of the interface.
+                    if (name == "home-scope" or is_location(name))
+                        continue;
+                    fnv.add(name);
+                    fnv.add(normalize(node, value));
+                }
+                fnv.add(node.children.size());
+                for (const auto* child : node.children)
+                    fnv.add(hash_of(*child));
+                return fnv.get();
+            }
+
+            // Replace the abstract indices written in the property value, e.g. "decl.scope-3",
+            // by what they stand for regardless of their position.
+            std::string normalize(const Node& node, std::string_view value)
+            {
+                std::string result{value};
+                // Longer tokens first, so that "decl.scope-12" is not taken for "decl.scope-1".
+                std::vector<std::pair<std::string, std::string>> tokens;
+                for (auto key : node.references)
+                {
+                    char buf[format_buffer_size];
+                    std::string token{buf, format_to(buf, key)};
+                    if (result.find(token) == std::string::npos)
+                        continue;
+                    if (key.kind() == SortKind::Decl)
+                    {
+                        auto index = index_like::make<DeclIndex>(static_cast<DeclSort>(key.sort()), key.index());
+                        tokens.emplace_back(std::move(token), qualified_name(index));
+                    }
+                    else
+                    {
+                        tokens.emplace_back(std::move(token), "#" + std::to_string(hash_of(ctx.get(key))));
+                    }
+                }
+                std::ranges::sort(tokens, std::ranges::greater{}, [](const auto& t) { return t.first.size(); });
+                for (const auto& [token, replacement] : tokens)
+                {
+                    for (auto pos = result.find(token); pos != std::string::npos; pos = result.find(token, pos))
+                    {
+                        const auto end = pos + token.size();
+                        const bool within = (pos > 0 and (std::isalnum(static_cast<unsigned char>(result[pos - 1]))
+                                                          or result[pos - 1] == '.'))
+                                            or (end < result.size() and result[end] >= '0' and result[end] <= '9');
+                        if (within)
+                        {
+                            pos = end;
+                            continue;
+                        }
+                        result.replace(pos, token.size(), replacement);
+                        pos += replacement.size();
+                    }
+                }
+                return result;
+            }
+
+            Loader& ctx;
+            std::map<NodeKey, std::string> names;
+            std::unordered_map<const Node*, uint64_t> hashes;
+            std::unordered_set<const Node*> open;
+            std::unordered_set<const Node*> in_cycle; // hashed from the current root only
+        };
+
+        struct Collected {
+            Entity entity;
+            std::string type; // to tell overloads apart
+        };
+
+        class Collector {
+        public:
+            Collector(Reader& reader, bool all_) : ctx(reader), hasher(ctx), all(all_) {}
+
+            // Collect the entity declared at index, or those in the namespace it declares.
+            void collect(DeclIndex index, std::vector<Collected>& out, const std::string& enclosing = {})
+            {
+                if (index.sort() == DeclSort::Scope)
+                {
+                    const auto& decl = ctx.reader.get<symbolic::ScopeDecl>(index);
+                    if (is_namespace(ctx.reader, decl))
+                    {
+                        const auto& name = hasher.qualified_name(index);
+                        if (const auto* scope = ctx.reader.try_get(decl.initializer))
+                            for (const auto& member : ctx.reader.sequence(*scope))
+                                collect(member.index, out, name);
+                        return;
+                    }
+                }
+                if (not all and not is_exported(ctx.reader, index))
+                    return;
+
+                const auto& node = ctx.get(index);
+                std::string type;
+                if (auto it = node.props.find("type"); it != node.props.end())
+                    type = it->second;
+                out.push_back(
+                    {{hasher.qualified_name(index), sort_name(index.sort()), hasher.hash(node), index, enclosing}, type});
+            }
+
+        private:
+            Loader ctx;
+            Hasher hasher;
+            bool all;
+        };
+
+        // Tell apart the entities of the same name by their type, then by their position.
+        void disambiguate(std::vector<Collected>& collected)
+        {
+            auto by_name = [](const Collected& a, const Collected& b) { return a.entity.name < b.entity.name; };
+            std::ranges::stable_sort(collected, by_name);
+            for (auto first = collected.begin(); first != collected.end();)
+            {
+                auto last = std::upper_bound(first, collected.end(), *first, by_name);
+                if (last - first > 1)
+                {
+                    std::map<std::string, int> seen;
+                    for (auto it = first; it != last; ++it)
+                    {
+                        auto& name = it->entity.name;
+                        name.append(" [").append(it->type).append("]");
+                        if (auto n = seen[name]++; n != 0)
+                            name.append("#").append(std::to_string(n));
+                    }
+                }
+                first = last;
+            }
+            std::ranges::stable_sort(collected, by_name);
+        }
+
+        gsl::span<const std::byte> bytes_of(const InputIfc& ifc, const PartitionSummaryData& summary)
+        {
+            const auto size = std::size_t{ifc::to_underlying(summary.cardinality)} * ifc::to_underlying(summary.entry_size);
+            return ifc.contents().subspan(ifc::to_underlying(summary.offset), size);
+        }
+
+        bool same_bytes(gsl::span<const std::byte> a, gsl::span<const std::byte> b)
+        {
+            return a.size() == b.size() and (a.empty() or std::memcmp(a.data(), b.data(), a.size()) == 0);
+        }
+    } // namespace
+
+    std::vector<Entity> interface_entities(const InputIfc& ifc, bool all, unsigned jobs)
+    {
+        Reader reader{ifc};
+        return interface_entities(reader, all, jobs);
+    }
+
+    std::vector<Entity> interface_entities(Reader& reader, bool all, unsigned jobs)
+    {
+        std::vector<DeclIndex> top_level;
+        if (const auto* global = reader.try_get(reader.ifc.header()->global_scope))
+            for (const auto& member : reader.sequence(*global))
+                top_level.push_back(member.index);
+
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+        jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(top_level.size())));
+
+        // Top-level declarations are claimed by the workers in order; each worker has its own loader.
+        std::vector<std::vector<Collected>> found(top_level.size());
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::atomic<std::size_t> next{0};
+        auto work = [&] {
+            try
+            {
+                Collector collector{reader, all};
+                for (std::size_t i; (i = next++) < top_level.size();)
+                    collector.collect(top_level[i], found[i]);
+            }
+            catch (...)
+            {
+                std::lock_guard lock{mutex};
+                if (not error)
+                    error = std::current_exception();
+                next = top_level.size();
+            }
+        };
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned i = 0; i < jobs; ++i)
+                workers.emplace_back(work);
+        }
+        if (error)
+            std::rethrow_exception(error);
+
+        std::vector<Collected> collected;
+        for (auto& part : found)
+            std::ranges::move(part, std::back_inserter(collected));
+        disambiguate(collected);
+
+        std::vector<Entity> result;
+        result.reserve(collected.size());
+        for (auto& c : collected)
+            result.push_back(std::move(c.entity));
+        return result;
+    }
+
+    bool same_partitions(const InputIfc& a, const InputIfc& b)
+    {
+        if (not same_bytes(*a.string_table(), *b.string_table()))
+            return false;
+        const auto partitions_a = a.partition_table();
+        const auto partitions_b = b.partition_table();
+        if (partitions_a.size() != partitions_b.size())
+            return false;
+
+        // The string tables are the same, so are the offsets of the partition names.
+        std::unordered_map<uint32_t, const PartitionSummaryData*> by_name;
+        for (const auto& summary : partitions_b)
+            by_name.emplace(ifc::to_underlying(summary.name), &summary);
+        for (const auto& summary : partitions_a)
+        {
+            auto it = by_name.find(ifc::to_underlying(summary.name));
+            if (it == by_name.end() or it->second->entry_size != summary.entry_size
+                or not same_bytes(bytes_of(a, summary), bytes_of(b, *it->second)))
+                return false;
+        }
+        return a.header()->global_scope == b.header()->global_scope;
+    }
+
+    SHA256Hash semantic_hash(const InputIfc& ifc, unsigned jobs)
+    {
+        return semantic_hash(ifc, interface_entities(ifc, false, jobs));
+    }
+
+    SHA256Hash semantic_hash(const InputIfc& ifc, const std::vector<Entity>& entities)
+    {
+        // The unit sort and module name, then one line per entity.
+        std::string text;
+        const auto unit = ifc.header()->unit;
+        text.append(std::to_string(ifc::to_underlying(unit.sort()))).push_back(' ');
+        if (unit.sort() != UnitSort::Source)
+        {
+            if (const char* name = ifc.get(unit.module_name()))
+                text.append(name);
+        }
+        text.push_back('\n');
+        for (const auto& entity : entities)
+        {
+            char buf[16];
+            auto end = std::to_chars(buf, buf + sizeof buf, entity.hash, 16).ptr;
+            text.append(entity.name).append(1, '\0').append(entity.kind).append(1, '\0');
+            text.append(sizeof buf - (end - buf), '0').append(buf, end).push_back('\n');
+        }
+        const auto* bytes = reinterpret_cast<const std::byte*>(text.data());
+        return hash_bytes(bytes, bytes + text.size());
+    }
+
+    std::vector<EntityChange> diff_interfaces(const InputIfc& before, const InputIfc& after, bool all, unsigned jobs)
+    {
+        if (same_partitions(before, after))
+            return {};
+        return diff_entities(interface_entities(before, all, jobs), interface_entities(after, all, jobs));
+    }
+
+    std::vector<EntityChange> diff_entities(const std::vector<Entity>& old_entities,
+                                            const std::vector<Entity>& new_entities)
+    {
+        std::vector<EntityChange> changes;
+        auto old_it = old_entities.begin();
+        auto new_it = new_entities.begin();
+        while (old_it != old_entities.end() or new_it != new_entities.end())
+        {
+            if (new_it == new_entities.end() or (old_it != old_entities.end() and old_it->name < new_it->name))
+            {
+                changes.push_back({Change::Removed, old_it->name, old_it->kind});
+                ++old_it;
+            }
+            else if (old_it == old_entities.end() or new_it->name < old_it->name)
+            {
+                changes.push_back({Change::Added, new_it->name, new_it->kind});
+                ++new_it;
+            }
+            else
+            {
+                if (old_it->hash != new_it->hash or std::strcmp(old_it->kind, new_it->kind) != 0)
+                    changes.push_back({Change::Changed, new_it->name, new_it->kind});
+                ++old_it;
+                ++new_it;
+            }
+        }
+        return changes;
+    }
+} // namespace ifc::util
@@ -0,0 +1,208 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/layout.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <unordered_set>
+
+namespace ifc::util {
+    namespace {
+        struct Item {
+            const Node* node;
+            uint32_t parent;
+            uint32_t depth;
+            std::vector<uint32_t> children;
+            uint32_t value = 0;
+            double x0      = 0;
+            double x1      = 1;
+        };
+
+        class Tree {
+        public:
+            explicit Tree(const Node& root)
+            {
+                items.push_back({&root, layout::no_parent, 0, {}});
+                seen.insert(&root);
+                // Items are appended breadth-first, so that a parent comes before its children.
+                for (uint32_t i = 0; i < items.size(); ++i)
+                    add_children(i, *items[i].node);
+            }
+
+            // Size each node by its leaves, then split the extent of each node among its children.
+            void layout()
+            {
+                for (auto& item : items)
+                    item.value = item.children.empty() ? 1 : 0;
+                // Children come after their parent.
+                for (auto i = items.size(); i-- > 1;)
+                    items[items[i].parent].value += items[i].value;
+
+                for (auto& item : items)
+                {
+                    std::stable_sort(item.children.begin(), item.children.end(),
+                                     [this](uint32_t a, uint32_t b) { return items[a].value > items[b].value; });
+                    auto x = item.x0;
+                    const auto scale = (item.x1 - item.x0) / item.value;
+                    for (auto child : item.children)
+                    {
+                        items[child].x0 = x;
+                        x += items[child].value * scale;
+                        items[child].x1 = x;
+                    }
+                }
+            }
+
+            std::vector<Item> items;
+
+        private:
+            // The children in the tree are the declarations among the children of the node,
+            // and those in the scopes among them.
+            void add_children(uint32_t position, const Node& node)
+            {
+                for (const auto* child : node.children)
+                {
+                    if (child->key.kind() == SortKind::Scope)
+                    {
+                        add_children(position, *child);
+                    }
+                    else if (child->key.kind() == SortKind::Decl and seen.insert(child).second)
+                    {
+                        const auto child_position = static_cast<uint32_t>(items.size());
+                        items.push_back({child, position, items[position].depth + 1, {}});
+                        items[position].children.push_back(child_position);
+                    }
+                }
+            }
+
+            std::unordered_set<const Node*> seen;
+        };
+
+        std::string_view label(const Item& item)
+        {
+            if (item.parent == layout::no_parent)
+                return "global";
+            if (auto it = item.node->props.find("name"); it != item.node->props.end() and not it->second.empty())
+                return it->second;
+            return item.node->id;
+        }
+
+        // Append the records, with their fields in little-endian order.  The fields are 32-bit, but
+        // for the kind and sort of a node, which are 16-bit.
+        template<typename T>
+        void append(std::vector<std::byte>& out, const T* data, std::size_t count)
+        {
+            const auto size = count * sizeof(T);
+            const auto base = out.size();
+            out.resize(base + size);
+            if (size != 0)
+                std::memcpy(out.data() + base, data, size);
+
+            if constexpr (std::endian::native == std::endian::big and sizeof(T) % 4 == 0)
+            {
+                const auto records = out.data() + base;
+                for (auto p = records; p != records + size; p += 4)
+                    std::reverse(p, p + 4);
+                // The reversal of its word also exchanged the kind and the sort.
+                if constexpr (std::same_as<T, layout::NodeRecord>)
+                {
+                    static_assert(offsetof(layout::NodeRecord, sort) == offsetof(layout::NodeRecord, kind) + 2);
+                    for (auto p = records + offsetof(layout::NodeRecord, kind); p < records + size; p += sizeof(T))
+                        std::rotate(p, p + 2, p + 4);
+                }
+            }
+        }
+    } // namespace
+
+    std::vector<std::byte> write_layout(const Node& root)
+    {
+        Tree tree{root};
+        tree.layout();
+        const auto& items = tree.items;
+
+        // Breadth-first order is row by row; sorting the children made each row left to right.
+        // Renumber the nodes in that order.
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> position(items.size());
+        order.reserve(items.size());
+        order.push_back(0);
+        for (uint32_t i = 0; i < order.size(); ++i)
+        {
+            position[order[i]] = i;
+            for (auto child : items[order[i]].children)
+                order.push_back(child);
+        }
+
+        uint32_t depth_count = 0;
+        for (const auto& item : items)
+            depth_count = std::max(depth_count, item.depth + 1);
+
+        std::vector<layout::NodeRecord> nodes;
+        std::vector<layout::Tile> tiles;
+        std::string labels;
+        std::map<NodeKey, uint32_t> positions;
+        nodes.reserve(items.size());
+        for (auto i : order)
+        {
+            const auto& item = items[i];
+            const auto text  = label(item);
+            const auto key   = item.node->key;
+            layout::NodeRecord record{};
+            record.x0           = static_cast<float>(item.x0);
+            record.x1           = static_cast<float>(item.x1);
+            record.y0           = static_cast<float>(item.depth) / depth_count;
+            record.y1           = static_cast<float>(item.depth + 1) / depth_count;
+            record.parent       = item.parent == layout::no_parent ? layout::no_parent : position[item.parent];
+            record.value        = item.value;
+            record.label_offset = static_cast<uint32_t>(labels.size());
+            record.label_length = static_cast<uint32_t>(text.size());
+            record.kind         = key.kind();
+            record.sort         = key.sort();
+            record.index        = key.index();
+            labels.append(text);
+            positions.emplace(key, static_cast<uint32_t>(nodes.size()));
+
+            auto* tile = tiles.empty() ? nullptr : &tiles.back();
+            if (tile == nullptr or tile->depth != item.depth or tile->node_count == layout::tile_nodes)
+                tile = &tiles.emplace_back(layout::Tile{item.depth, static_cast<uint32_t>(nodes.size()), 0, record.x0, record.x1});
+            ++tile->node_count;
+            tile->x1 = record.x1;
+
+            nodes.push_back(record);
+        }
+
+        std::vector<layout::Edge> edges;
+        for (auto i : order)
+        {
+            const auto& item = items[i];
+            for (const auto& reference : item.node->references)
+            {
+                if (auto it = positions.find(reference); it != positions.end())
+                    edges.push_back({position[i], it->second});
+            }
+        }
+
+        layout::Header header{};
+        header.magic       = layout::magic;
+        header.version     = layout::version;
+        header.tile_count  = static_cast<uint32_t>(tiles.size());
+        header.node_count  = static_cast<uint32_t>(nodes.size());
+        header.edge_count  = static_cast<uint32_t>(edges.size());
+        header.depth_count = depth_count;
+        header.label_bytes = static_cast<uint32_t>(labels.size());
+
+        std::vector<std::byte> result;
+        append(result, &header, 1);
+        append(result, tiles.data(), tiles.size());
+        append(result, nodes.data(), nodes.size());
+        append(result, edges.data(), edges.size());
+        append(result, labels.data(), labels.size());
+        result.resize((result.size() + 3) & ~std::size_t{3});
+        return result;
+    }
+} // namespace ifc::util
@@ -0,0 +1,110 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/merged.hxx"
+
+#include <algorithm>
+#include <map>
+#include <ranges>
+#include <tuple>
+
+namespace ifc::util {
+    namespace {
+        struct Found {
+            Entity entity;
+            std::string_view owner;
+            uint32_t file;
+        };
+
+        // The name of the module owning the declaration, empty for the global module.
+        std::string_view owner_of(Reader& reader, DeclIndex index)
+        {
+            const auto unit = reader.ifc.header()->unit;
+            if (unit.sort() != UnitSort::Primary and unit.sort() != UnitSort::Partition)
+                return {};
+            const bool global = reader.visit_with_index(index, [](DeclIndex, const auto& decl) {
+                if constexpr (requires { decl.basic_spec; })
+                    return ifc::implies(decl.basic_spec, BasicSpecifiers::IsMemberOfGlobalModule);
+                else
+                    return false;
+            });
+            if (global)
+                return {};
+            const char* name = reader.get(unit.module_name());
+            return name == nullptr ? std::string_view{} : std::string_view{name};
+        }
+
+        auto key_of(const Found& f)
+        {
+            return std::make_tuple(std::string_view{f.entity.name}, std::string_view{f.entity.kind}, f.entity.hash,
+                                   f.owner);
+        }
+    } // namespace
+
+    MergedReader::MergedReader(std::vector<Reader*> readers_, bool all, unsigned jobs) : readers(std::move(readers_))
+    {
+        std::vector<Found> found;
+        for (uint32_t file = 0; file < readers.size(); ++file)
+        {
+            auto& reader = *readers[file];
+            for (auto& entity : interface_entities(reader, all, jobs))
+            {
+                const auto owner = owner_of(reader, entity.decl);
+                found.push_back({std::move(entity), owner, file});
+            }
+        }
+        declaration_count = found.size();
+        // Equal entities end up next to one another, by file.
+        std::ranges::stable_sort(found, [](const Found& a, const Found& b) { return key_of(a) < key_of(b); });
+
+        std::map<std::string, uint32_t, std::less<>> scope_index;
+        scopes.push_back({});
+        scope_index.emplace("", 0);
+        // The namespace of that qualified name, created with the enclosing ones if needed.
+        auto scope_of = [&](std::string_view name) {
+            std::vector<std::string_view> missing;
+            auto it = scope_index.find(name);
+            while (it == scope_index.end())
+            {
+                missing.push_back(name);
+                const auto colons = name.rfind("::");
+                name              = colons == std::string_view::npos ? std::string_view{} : name.substr(0, colons);
+                it                = scope_index.find(name);
+            }
+            auto index = it->second;
+            for (auto inner : missing | std::views::reverse)
+            {
+                const auto parent = index;
+                index             = static_cast<uint32_t>(scopes.size());
+                scopes.push_back({std::string{inner}, {}, {}});
+                scopes[parent].scopes.push_back(index);
+                scope_index.emplace(inner, index);
+            }
+            return index;
+        };
+
+        for (auto first = found.begin(); first != found.end();)
+        {
+            auto last = std::find_if(first, found.end(), [&](const Found& f) { return key_of(f) != key_of(*first); });
+            MergedEntity entity{first->entity.name, first->entity.kind, first->entity.hash, first->owner, {}};
+            for (auto it = first; it != last; ++it)
+                entity.sources.push_back({it->file, it->entity.decl});
+            const auto index = static_cast<uint32_t>(merged.size());
+            scopes[scope_of(first->entity.scope)].members.push_back(index);
+            merged.push_back(std::move(entity));
+            first = last;
+        }
+
+        for (auto& scope : scopes)
+            std::ranges::sort(scope.scopes, {}, [&](uint32_t index) -> const std::string& { return scopes[index].name; });
+    }
+
+    gsl::span<const MergedEntity> MergedReader::find(std::string_view name) const
+    {
+        auto [first, last] = std::ranges::equal_range(merged, name, {}, [](const MergedEntity& e) -> std::string_view {
+            return e.name;
+        });
+        const auto offset = static_cast<std::size_t>(first - merged.begin());
+        return gsl::span<const MergedEntity>{merged}.subspan(offset, static_cast<std::size_t>(last - first));
+    }
+} // namespace ifc::util
@@ -0,0 +1,284 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/modules.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace ifc::util {
+    namespace fs = std::filesystem;
+
+    namespace {
+        std::string text(const InputIfc& ifc, TextOffset offset)
+        {
+            const char* chars = ifc.get(offset);
+            return chars == nullptr ? std::string{} : std::string{chars};
+        }
+
+        void add_references(const Reader& reader, const PartitionSummaryData& summary, std::vector<ModuleName>& names)
+        {
+            for (const auto& ref : reader.ifc.view_partition<symbolic::ModuleReference>(summary))
+            {
+                ModuleName name{text(reader.ifc, ref.owner), text(reader.ifc, ref.partition)};
+                if (std::ranges::find(names, name) == names.end())
+                    names.push_back(std::move(name));
+            }
+        }
+
+        std::optional<fs::path> existing(const fs::path& path)
+        {
+            std::error_code error;
+            if (fs::is_regular_file(path, error))
+                return path;
+            return std::nullopt;
+        }
+
+        // The file of a module, and the name under which it was asked for.
+        struct Request {
+            fs::path path;
+            ModuleName name;
+        };
+    } // namespace
+
+    std::string to_string(const ModuleName& name)
+    {
+        if (name.header_unit() or name.partition.empty())
+            return name.header_unit() ? name.partition : name.owner;
+        return name.owner + ":" + name.partition;
+    }
+
+    ModuleName unit_name(const InputIfc& ifc)
+    {
+        const auto unit = ifc.header()->unit;
+        return unit_name(unit.sort(), text(ifc, unit.module_name()));
+    }
+
+    ModuleName unit_name(UnitSort sort, std::string name)
+    {
+        switch (sort)
+        {
+        case UnitSort::Primary:
+        case UnitSort::ExportedTU:
+            return {std::move(name), {}};
+        case UnitSort::Partition:
+        {
+            const auto colon = name.find(':');
+            if (colon == std::string::npos)
+                return {std::move(name), {}};
+            return {name.substr(0, colon), name.substr(colon + 1)};
+        }
+        case UnitSort::Header:
+            return {{}, std::move(name)};
+        default:
+            return {};
+        }
+    }
+
+    std::vector<ModuleName> module_dependencies(const Reader& reader)
+    {
+        std::vector<ModuleName> names;
+        const auto& toc = reader.table_of_contents();
+        add_references(reader, toc.imported_modules, names);
+        add_references(reader, toc.exported_modules, names);
+        return names;
+    }
+
+    ModuleResolver search_path_resolver(std::vector<fs::path> directories)
+    {
+        return [directories = std::move(directories)](const ModuleName& name) -> std::optional<fs::path> {
+            fs::path file;
+            if (name.header_unit())
+            {
+                const fs::path header{name.partition};
+                if (auto path = existing(fs::path{header}.concat(".ifc")))
+                    return path;
+                file = header.filename().concat(".ifc");
+            }
+            else
+            {
+                file = name.partition.empty() ? name.owner + ".ifc" : name.owner + "-" + name.partition + ".ifc";
+            }
+            for (const auto& directory : directories)
+            {
+                if (auto path = existing(directory / file))
+                    return path;
+            }
+            return std::nullopt;
+        };
+    }
+
+    std::unique_ptr<Module> load_module(const fs::path& path)
+    {
+        auto module = std::make_unique<Module>();
+        module->path = path;
+        std::ifstream stream{path, std::ios_base::binary};
+        if (not stream)
+            throw IfcReadFailure{Pathname{path.u8string()}};
+        module->contents.resize(fs::file_size(path));
+        if (not stream.read(reinterpret_cast<char*>(module->contents.data()),
+                            static_cast<std::streamsize>(module->contents.size())))
+            throw IfcReadFailure{Pathname{path.u8string()}};
+
+        // Any unit is accepted: a mismatch with the (empty) expected designator is not an error.
+        module->file = InputIfc{gsl::span(module->contents)};
+        module->file.validate<UnitSort::Primary>(Pathname{path.u8string()}, Architecture::Unknown, Pathname{},
+                                                 IfcOptions::IntegrityCheck);
+        if (module->file.header() == nullptr)
+            throw IfcReadFailure{Pathname{path.u8string()}};
+        module->file_reader = std::make_unique<Reader>(module->file);
+        module->name        = unit_name(module->file);
+        return module;
+    }
+
+    ModuleSet::ModuleSet(const fs::path& root, ModuleResolver resolver, unsigned jobs)
+    {
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+
+        std::map<fs::path, uint32_t> by_path;
+        auto key = [](const fs::path& path) {
+            std::error_code error;
+            auto canonical = fs::weakly_canonical(path, error);
+            return error ? path : canonical;
+        };
+
+        std::vector<Request> round{{root, {}}};
+        by_path.emplace(key(root), 0);
+        while (not round.empty())
+        {
+            // Files are claimed by the workers in order.
+            std::vector<std::unique_ptr<Module>> loaded(round.size());
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::atomic<std::size_t> next{0};
+            auto work = [&] {
+                try
+                {
+                    for (std::size_t i; (i = next++) < round.size();)
+                        loaded[i] = load_module(round[i].path);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock{mutex};
+                    if (not error)
+                        error = std::current_exception();
+                    next = round.size();
+                }
+            };
+            {
+                std::vector<std::jthread> workers;
+                const auto n = std::min<std::size_t>(jobs, round.size());
+                for (std::size_t i = 0; i < n; ++i)
+                    workers.emplace_back(work);
+            }
+            if (error)
+                std::rethrow_exception(error);
+
+            const auto first = static_cast<uint32_t>(modules.size());
+            for (std::size_t i = 0; i < loaded.size(); ++i)
+            {
+                if (loaded[i]->name == ModuleName{})
+                    loaded[i]->name = round[i].name;
+                if (loaded[i]->name != ModuleName{})
+                    by_name.emplace(loaded[i]->name, static_cast<uint32_t>(first + i));
+                modules.push_back(std::move(loaded[i]));
+            }
+
+            // The dependencies of this round make the next one.
+            std::vector<Request> next_round;
+            for (auto index = first; index < modules.size(); ++index)
+            {
+                auto& module = *modules[index];
+                for (auto& name : module_dependencies(module.reader()))
+                {
+                    auto depend_on = [&module](uint32_t dependency) {
+                        if (std::ranges::find(module.dependencies, dependency) == module.dependencies.end())
+                            module.dependencies.push_back(dependency);
+                    };
+                    if (auto it = by_name.find(name); it != by_name.end())
+                    {
+                        depend_on(it->second);
+                        continue;
+                    }
+                    auto path = resolver(name);
+                    if (not path)
+                    {
+                        module.unresolved.push_back(std::move(name));
+                        continue;
+                    }
+                    auto [it, inserted] =
+                        by_path.emplace(key(*path), static_cast<uint32_t>(modules.size() + next_round.size()));
+                    if (inserted)
+                        next_round.push_back({std::move(*path), name});
+                    depend_on(it->second);
+                    by_name.emplace(std::move(name), it->second);
+                }
+            }
+            round = std::move(next_round);
+        }
+        sort_dependencies();
+    }
+
+    std::optional<uint32_t> ModuleSet::find(const ModuleName& name) const
+    {
+        if (auto it = by_name.find(name); it != by_name.end())
+            return it->second;
+        return std::nullopt;
+    }
+
+    void ModuleSet::sort_dependencies()
+    {
+        // Depth-first walk with an explicit stack, from every module in turn: a module is placed
+        // when all of its dependencies are, and a dependency still on the stack closes a cycle.
+        enum class Mark : uint8_t {
+            New,
+            Open,
+            Placed,
+        };
+        std::vector<Mark> marks(modules.size(), Mark::New);
+        struct Step {
+            uint32_t module;
+            std::size_t next; // next dependency to look at
+        };
+        for (uint32_t start = 0; start < modules.size(); ++start)
+        {
+            if (marks[start] != Mark::New)
+                continue;
+            std::vector<Step> path{{start, 0}};
+            marks[start] = Mark::Open;
+            while (not path.empty())
+            {
+                auto& step       = path.back();
+                const auto& deps = modules[step.module]->dependencies;
+                if (step.next == deps.size())
+                {
+                    marks[step.module] = Mark::Placed;
+                    order.push_back(step.module);
+                    path.pop_back();
+                    continue;
+                }
+                const auto dep = deps[step.next++];
+                if (marks[dep] == Mark::Open)
+                {
+                    ModuleCycle cycle;
+                    auto it = std::ranges::find(path, dep, &Step::module);
+                    for (; it != path.end(); ++it)
+                        cycle.names.push_back(to_string(modules[it->module]->name));
+                    cycle.names.push_back(to_string(modules[dep]->name));
+                    throw cycle;
+                }
+                if (marks[dep] == Mark::New)
+                {
+                    marks[dep] = Mark::Open;
+                    path.push_back({dep, 0});
+                }
+            }
+        }
+    }
+} // namespace ifc::util
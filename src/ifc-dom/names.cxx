@@ -63,7 +63,7 @@ namespace ifc::util {
 
     void load(Loader&, Node& node, NameIndex index)
     {
-        node.id = to_string(index);
+        append_to(node.id, index);
     }
 
 } // namespace ifc::util
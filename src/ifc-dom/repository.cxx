@@ -0,0 +1,62 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/repository.hxx"
+
+#include <algorithm>
+
+namespace ifc::util {
+    namespace fs = std::filesystem;
+
+    gsl::span<const Entity> OpenedIfc::find(std::string_view name) const
+    {
+        // Overloads are named by the entity name followed by their type in brackets.
+        auto first = std::ranges::lower_bound(entities, name, {}, &Entity::name);
+        auto last  = first;
+        while (last != entities.end() and last->name.starts_with(name)
+               and (last->name.size() == name.size() or last->name.compare(name.size(), 2, " [") == 0))
+            ++last;
+        const auto offset = static_cast<std::size_t>(first - entities.begin());
+        return gsl::span<const Entity>{entities}.subspan(offset, static_cast<std::size_t>(last - first));
+    }
+
+    std::shared_ptr<const OpenedIfc> Repository::open(const fs::path& path)
+    {
+        std::error_code error;
+        auto key = fs::weakly_canonical(path, error);
+        if (error)
+            key = path;
+        const auto size  = fs::file_size(key, error);
+        const auto mtime = fs::last_write_time(key, error);
+        if (error)
+            throw IfcReadFailure{Pathname{path.u8string()}};
+
+        {
+            std::lock_guard lock{mutex};
+            if (auto it = opened.find(key); it != opened.end() and it->second->size == size
+                                            and it->second->mtime == mtime)
+                return it->second;
+        }
+
+        // Files are read without the lock, so that queries on other files go on meanwhile; two
+        // threads asking for the same new file may both read it.
+        auto file      = std::make_shared<OpenedIfc>();
+        file->module   = load_module(key);
+        file->size     = size;
+        file->mtime    = mtime;
+        file->entities = interface_entities(file->module->reader(), true, jobs);
+
+        std::lock_guard lock{mutex};
+        opened.insert_or_assign(key, file);
+        return file;
+    }
+
+    std::vector<fs::path> Repository::files() const
+    {
+        std::lock_guard lock{mutex};
+        std::vector<fs::path> paths;
+        for (const auto& [path, file] : opened)
+            paths.push_back(path);
+        return paths;
+    }
+} // namespace ifc::util
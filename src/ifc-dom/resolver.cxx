@@ -0,0 +1,275 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/resolver.hxx"
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string_view>
+
+namespace ifc::util {
+    namespace fs = std::filesystem;
+
+    namespace {
+        // First line of a saved index.
+        constexpr std::string_view index_signature = "ifc-module-index 1";
+
+        // The words of the hash are written as their bytes in memory, as `ifc hash` does.
+        std::string to_hex(const SHA256Hash& hash)
+        {
+            constexpr char digits[] = "0123456789abcdef";
+            uint8_t bytes[sizeof hash.value];
+            std::memcpy(bytes, hash.value.data(), sizeof bytes);
+            std::string result;
+            for (auto b : bytes)
+            {
+                result.push_back(digits[b >> 4]);
+                result.push_back(digits[b & 0xF]);
+            }
+            return result;
+        }
+
+        std::optional<SHA256Hash> from_hex(std::string_view hex)
+        {
+            SHA256Hash hash;
+            uint8_t bytes[sizeof hash.value];
+            if (hex.size() != 2 * sizeof bytes)
+                return std::nullopt;
+            for (std::size_t i = 0; i < sizeof bytes; ++i)
+            {
+                const auto* first = hex.data() + 2 * i;
+                if (std::from_chars(first, first + 2, bytes[i], 16).ptr != first + 2)
+                    return std::nullopt;
+            }
+            std::memcpy(hash.value.data(), bytes, sizeof bytes);
+            return hash;
+        }
+
+        // Split a line of a saved index into its tab-separated fields.
+        std::vector<std::string_view> fields_of(std::string_view line)
+        {
+            std::vector<std::string_view> fields;
+            for (std::size_t start = 0;;)
+            {
+                const auto tab = line.find('\t', start);
+                fields.push_back(line.substr(start, tab - start));
+                if (tab == std::string_view::npos)
+                    return fields;
+                start = tab + 1;
+            }
+        }
+
+        template<typename T>
+        bool parse(std::string_view text, T& value)
+        {
+            const auto last = text.data() + text.size();
+            return std::from_chars(text.data(), last, value).ptr == last;
+        }
+
+        // The number of leading components the two paths have in common.
+        std::size_t common_prefix(const fs::path& a, const fs::path& b)
+        {
+            std::size_t n = 0;
+            for (auto i = a.begin(), j = b.begin(); i != a.end() and j != b.end() and *i == *j; ++i, ++j)
+                ++n;
+            return n;
+        }
+
+        bool is_under(const fs::path& path, const fs::path& directory)
+        {
+            const auto components = static_cast<std::size_t>(std::distance(directory.begin(), directory.end()));
+            return common_prefix(path, directory) == components;
+        }
+    } // namespace
+
+    std::optional<IndexedModule> read_unit(const fs::path& path)
+    {
+        std::ifstream stream{path, std::ios_base::binary};
+        char signature[sizeof InterfaceSignature];
+        Header header;
+        if (not stream.read(signature, sizeof signature)
+            or std::memcmp(signature, InterfaceSignature, sizeof signature) != 0
+            or not stream.read(reinterpret_cast<char*>(&header), sizeof header))
+            return std::nullopt;
+
+        const auto sort = header.unit.sort();
+        if (sort == UnitSort::Source or sort >= UnitSort::Count)
+            return std::nullopt;
+        const auto offset = ifc::to_underlying(header.unit.module_name());
+        if (offset >= ifc::to_underlying(header.string_table_size))
+            return std::nullopt;
+
+        // Only the name is read from the string table.
+        std::string name;
+        if (not stream.seekg(ifc::to_underlying(header.string_table_bytes) + std::streamoff{offset})
+            or not std::getline(stream, name, '\0'))
+            return std::nullopt;
+
+        std::error_code error;
+        const auto size  = fs::file_size(path, error);
+        const auto mtime = fs::last_write_time(path, error);
+        if (error)
+            return std::nullopt;
+        return IndexedModule{unit_name(sort, std::move(name)), sort, header.content_hash, size,
+                             mtime.time_since_epoch().count()};
+    }
+
+    ModuleIndex::ModuleIndex(std::vector<fs::path> directories_) : directories(std::move(directories_))
+    {
+        for (auto& directory : directories)
+        {
+            directory = directory.lexically_normal();
+            if (not directory.has_filename() and directory.has_parent_path())
+                directory = directory.parent_path();
+        }
+    }
+
+    bool ModuleIndex::load(const fs::path& file)
+    {
+        entries.clear();
+        std::ifstream stream{file};
+        std::string line;
+        if (not std::getline(stream, line) or line != index_signature)
+            return false;
+
+        // mtime, size, content hash, unit sort, owner, partition, path
+        while (std::getline(stream, line))
+        {
+            const auto fields = fields_of(line);
+            IndexedModule module{};
+            uint8_t sort = 0;
+            std::optional<SHA256Hash> hash;
+            if (fields.size() != 7 or not parse(fields[0], module.mtime) or not parse(fields[1], module.size)
+                or not (hash = from_hex(fields[2])) or not parse(fields[3], sort)
+                or sort >= ifc::to_underlying(UnitSort::Count))
+            {
+                entries.clear();
+                return false;
+            }
+            module.content_hash = *hash;
+            module.sort         = UnitSort(sort);
+            module.name         = {std::string{fields[4]}, std::string{fields[5]}};
+            const std::u8string path{fields[6].begin(), fields[6].end()};
+            entries.insert_or_assign(fs::path{path}.lexically_normal(), std::move(module));
+        }
+        rebuild_names();
+        return true;
+    }
+
+    void ModuleIndex::save(const fs::path& file) const
+    {
+        // Write aside, then replace, so that a concurrent reader never sees half an index.
+        auto temporary = file;
+        temporary += ".tmp";
+        {
+            std::ofstream stream{temporary, std::ios_base::binary | std::ios_base::trunc};
+            stream << index_signature << '\n';
+            for (const auto& [path, module] : entries)
+            {
+                const auto u8path = path.generic_u8string();
+                stream << module.mtime << '\t' << module.size << '\t' << to_hex(module.content_hash) << '\t'
+                       << int{ifc::to_underlying(module.sort)} << '\t' << module.name.owner << '\t'
+                       << module.name.partition << '\t';
+                stream.write(reinterpret_cast<const char*>(u8path.data()), static_cast<std::streamsize>(u8path.size()));
+                stream << '\n';
+            }
+            if (not stream.flush())
+                throw "couldn't write the module index";
+        }
+        fs::rename(temporary, file);
+    }
+
+    IndexUpdate ModuleIndex::update()
+    {
+        IndexUpdate update;
+        std::set<fs::path> seen;
+        for (const auto& directory : directories)
+        {
+            std::error_code error;
+            fs::recursive_directory_iterator it{directory, fs::directory_options::skip_permission_denied, error};
+            for (; not error and it != fs::recursive_directory_iterator{}; it.increment(error))
+            {
+                const auto& entry = *it;
+                if (entry.path().extension() != ".ifc" or not entry.is_regular_file(error))
+                    continue;
+                const auto path = entry.path().lexically_normal();
+                if (not seen.insert(path).second)
+                    continue;
+                ++update.scanned;
+
+                const auto size  = entry.file_size(error);
+                const auto mtime = entry.last_write_time(error).time_since_epoch().count();
+                auto known       = entries.find(path);
+                if (known != entries.end() and known->second.size == size and known->second.mtime == mtime)
+                    continue;
+
+                ++update.read;
+                if (auto module = read_unit(path))
+                    entries.insert_or_assign(path, std::move(*module));
+                else if (known != entries.end())
+                    entries.erase(known);
+            }
+        }
+
+        std::erase_if(entries, [&](const auto& entry) {
+            if (seen.contains(entry.first))
+                return false;
+            ++update.removed;
+            return true;
+        });
+        rebuild_names();
+        return update;
+    }
+
+    std::optional<fs::path> ModuleIndex::find(const ModuleName& name) const
+    {
+        if (auto it = by_name.find(name); it != by_name.end())
+            return it->second;
+        // Header units are also found by a spelling of the path of the header other than the
+        // one they were built with.
+        if (name.header_unit())
+        {
+            const auto header = fs::path{name.partition}.lexically_normal();
+            for (const auto& [path, module] : entries)
+            {
+                if (module.name.header_unit() and fs::path{module.name.partition}.lexically_normal() == header)
+                    return path;
+            }
+        }
+        return std::nullopt;
+    }
+
+    ModuleResolver ModuleIndex::resolver() const
+    {
+        return [this](const ModuleName& name) { return find(name); };
+    }
+
+    void ModuleIndex::rebuild_names()
+    {
+        by_name.clear();
+        // The directories are looked at in order, the files of each by path.
+        std::vector<bool> named(entries.size());
+        for (const auto& directory : directories)
+        {
+            std::size_t i = 0;
+            for (const auto& [path, module] : entries)
+            {
+                if (not named[i] and is_under(path, directory))
+                {
+                    by_name.emplace(module.name, path);
+                    named[i] = true;
+                }
+                ++i;
+            }
+        }
+        // Files of a loaded index that no directory holds anymore are still found until updated.
+        std::size_t i = 0;
+        for (const auto& [path, module] : entries)
+        {
+            if (not named[i++])
+                by_name.emplace(module.name, path);
+        }
+    }
+} // namespace ifc::util
@@ -8,6 +8,6 @@ namespace ifc::util {
     {
         // At some point all of the token based initializers will be going
         // away. If that does not happen. We can add token loading here.
-        node.id = to_string(index);
+        append_to(node.id, index);
     }
 } // namespace ifc::util
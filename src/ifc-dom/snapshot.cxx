@@ -0,0 +1,269 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/snapshot.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+namespace ifc::util {
+    namespace {
+        snapshot::Key to_key(NodeKey key)
+        {
+            return {key.kind(), key.sort(), key.index()};
+        }
+
+        NodeKey to_node_key(const snapshot::Key& key)
+        {
+            return {key.kind, key.sort, key.index};
+        }
+
+        // String bytes of a snapshot being written; equal strings are stored once.
+        class StringTable {
+        public:
+            snapshot::StringRef add(std::string_view str)
+            {
+                auto [it, inserted] = offsets.try_emplace(str);
+                if (inserted)
+                {
+                    it->second = {static_cast<uint32_t>(bytes.size()), static_cast<uint32_t>(str.size())};
+                    bytes.append(str);
+                }
+                return it->second;
+            }
+
+            const std::string& contents() const
+            {
+                return bytes;
+            }
+
+        private:
+            // Keys point into the nodes being written, which outlive the table.
+            std::unordered_map<std::string_view, snapshot::StringRef> offsets;
+            std::string bytes;
+        };
+
+        template<typename T>
+        void write(std::vector<std::byte>& out, const T* data, std::size_t count)
+        {
+            const auto size = count * sizeof(T);
+            const auto base = out.size();
+            out.resize(base + size);
+            if (size != 0)
+                std::memcpy(out.data() + base, data, size);
+        }
+
+        template<typename T>
+        std::size_t byte_length(uint32_t count)
+        {
+            return std::size_t{count} * sizeof(T);
+        }
+
+        // This predicate holds if the `count` items from `first` are among the first `size`.
+        bool within(uint32_t first, uint32_t count, std::size_t size)
+        {
+            return std::size_t{first} + count <= size;
+        }
+
+        template<typename S>
+        bool is_index_over(const snapshot::Key& key)
+        {
+            return key.sort < ifc::to_underlying(S::Count)
+                   and ifc::bit_length(key.index) <= index_like::index_precision<S>;
+        }
+
+        // This predicate holds if the key designates an abstract index that a loader can visit.
+        bool is_valid(const snapshot::Key& key)
+        {
+            switch (key.kind)
+            {
+            case SortKind::Expr:
+                return is_index_over<ExprSort>(key);
+            case SortKind::Decl:
+                return is_index_over<DeclSort>(key);
+            case SortKind::Type:
+                return is_index_over<TypeSort>(key);
+            case SortKind::Name:
+                return is_index_over<NameSort>(key);
+            case SortKind::Chart:
+                return is_index_over<ChartSort>(key);
+            case SortKind::Syntax:
+                return is_index_over<SyntaxSort>(key);
+            case SortKind::Stmt:
+                return is_index_over<StmtSort>(key);
+            case SortKind::Scope:
+            case SortKind::Sentence:
+                return key.sort == 0;
+            default:
+                return false;
+            }
+        }
+    } // namespace
+
+    Snapshot::Snapshot(gsl::span<const std::byte> bytes)
+    {
+        if (bytes.size() < sizeof(snapshot::Header)
+            or reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(snapshot::Header) != 0)
+            throw InvalidSnapshot{};
+
+        header = reinterpret_cast<const snapshot::Header*>(bytes.data());
+        if (header->magic != snapshot::magic or header->version != snapshot::version)
+            throw InvalidSnapshot{};
+
+        const auto node_bytes     = byte_length<snapshot::NodeRecord>(header->node_count);
+        const auto property_bytes = byte_length<snapshot::PropertyRecord>(header->property_count);
+        const auto edge_bytes     = byte_length<snapshot::Key>(header->edge_count);
+        if (bytes.size() - sizeof(snapshot::Header) < node_bytes + property_bytes + edge_bytes + header->string_bytes)
+            throw InvalidSnapshot{};
+
+        auto cursor      = bytes.data() + sizeof(snapshot::Header);
+        node_records     = {reinterpret_cast<const snapshot::NodeRecord*>(cursor), header->node_count};
+        cursor          += node_bytes;
+        property_records = {reinterpret_cast<const snapshot::PropertyRecord*>(cursor), header->property_count};
+        cursor          += property_bytes;
+        edges            = {reinterpret_cast<const snapshot::Key*>(cursor), header->edge_count};
+        cursor          += edge_bytes;
+        strings          = {reinterpret_cast<const char*>(cursor), header->string_bytes};
+
+        // The records are read in place, without further checks: a snapshot that was truncated or
+        // overwritten is rejected here rather than followed out of bounds.
+        auto valid_string = [&](snapshot::StringRef str) { return within(str.offset, str.length, strings.size()); };
+        const snapshot::Key* previous = nullptr;
+        for (const auto& node : node_records)
+        {
+            if (not is_valid(node.key) or not valid_string(node.id)
+                or not within(node.first_property, node.property_count, property_records.size())
+                or not within(node.first_child, node.child_count, edges.size())
+                or not within(node.first_reference, node.reference_count, edges.size()))
+                throw InvalidSnapshot{};
+            // find() looks the records up by key.
+            if (previous != nullptr and to_node_key(node.key) <= to_node_key(*previous))
+                throw InvalidSnapshot{};
+            previous = &node.key;
+        }
+        for (const auto& property : property_records)
+        {
+            if (not valid_string(property.name) or not valid_string(property.value))
+                throw InvalidSnapshot{};
+        }
+        if (not std::ranges::all_of(edges, is_valid))
+            throw InvalidSnapshot{};
+    }
+
+    bool Snapshot::matches(const Header& ifc_header) const
+    {
+        return header->content_hash.value == ifc_header.content_hash.value;
+    }
+
+    const snapshot::NodeRecord* Snapshot::find(NodeKey key) const
+    {
+        auto it = std::lower_bound(node_records.begin(), node_records.end(), key,
+                                   [](const snapshot::NodeRecord& x, NodeKey y) { return to_node_key(x.key) < y; });
+        if (it == node_records.end() or to_node_key(it->key) != key)
+            return nullptr;
+        return &*it;
+    }
+
+    std::vector<std::byte> write_snapshot(const Loader& loader)
+    {
+        // Only fully populated nodes can be recorded.
+        IFCASSERT(loader.pending.empty());
+
+        std::vector<snapshot::NodeRecord> nodes;
+        std::vector<snapshot::PropertyRecord> properties;
+        std::vector<snapshot::Key> edges;
+        StringTable strings;
+
+        // The node map is ordered by key, and so are the records.
+        nodes.reserve(loader.all_nodes.size());
+        for (const auto& [key, node] : loader.all_nodes)
+        {
+            snapshot::NodeRecord record{};
+            record.key = to_key(key);
+            record.id  = strings.add(node.id);
+
+            record.first_property = static_cast<uint32_t>(properties.size());
+            for (const auto& [name, value] : node.props)
+                properties.push_back({strings.add(name), strings.add(value)});
+            record.property_count = static_cast<uint32_t>(properties.size() - record.first_property);
+
+            record.first_child = static_cast<uint32_t>(edges.size());
+            for (const auto* child : node.children)
+                edges.push_back(to_key(child->key));
+            record.child_count = static_cast<uint32_t>(edges.size() - record.first_child);
+
+            record.first_reference = static_cast<uint32_t>(edges.size());
+            for (const auto& reference : node.references)
+                edges.push_back(to_key(reference));
+            record.reference_count = static_cast<uint32_t>(edges.size() - record.first_reference);
+
+            nodes.push_back(record);
+        }
+
+        snapshot::Header header{};
+        header.magic          = snapshot::magic;
+        header.version        = snapshot::version;
+        header.content_hash   = loader.reader.ifc.header()->content_hash;
+        header.node_count     = static_cast<uint32_t>(nodes.size());
+        header.property_count = static_cast<uint32_t>(properties.size());
+        header.edge_count     = static_cast<uint32_t>(edges.size());
+        header.string_bytes   = static_cast<uint32_t>(strings.contents().size());
+
+        std::vector<std::byte> result;
+        write(result, &header, 1);
+        write(result, nodes.data(), nodes.size());
+        write(result, properties.data(), properties.size());
+        write(result, edges.data(), edges.size());
+        write(result, strings.contents().data(), strings.contents().size());
+        return result;
+    }
+
+    std::string snapshot_file_name(const SHA256Hash& hash)
+    {
+        std::string result;
+        for (auto word : hash.value)
+        {
+            char buf[8];
+            auto end = std::to_chars(buf, buf + sizeof buf, word, 16).ptr;
+            result.append(sizeof buf - (end - buf), '0').append(buf, end);
+        }
+        return result.append(".ifcdom");
+    }
+
+    void Loader::attach(const Snapshot& snap)
+    {
+        if (not snap.matches(*reader.ifc.header()))
+            throw InvalidSnapshot{};
+        snapshot = &snap;
+    }
+
+    bool Loader::queue_restore(Node& node)
+    {
+        auto* record = snapshot->find(node.key);
+        if (record == nullptr)
+            return false;
+
+        const auto position = static_cast<uint32_t>(record - snapshot->nodes().data());
+        pending.push_back({&node, index_like::Index{position}, &restore_pending, ByteOffset{}});
+        return true;
+    }
+
+    void Loader::restore_pending(Loader& ctx, Node& node, index_like::Index record)
+    {
+        const auto& snap = *ctx.snapshot;
+        const auto& item = snap.nodes()[ifc::to_underlying(record)];
+
+        node.id = snap.string(item.id);
+        for (const auto& prop : snap.properties(item))
+            node.props.emplace_hint(node.props.end(), snap.string(prop.name), snap.string(prop.value));
+
+        node.children.reserve(item.child_count);
+        for (const auto& child : snap.children(item))
+            node.children.push_back(&ctx.enqueue(to_node_key(child)));
+
+        for (const auto& reference : snap.references(item))
+            ctx.reference(to_node_key(reference));
+    }
+} // namespace ifc::util
@@ -0,0 +1,221 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/stats.hxx"
+#include "ifc/dom/canonical.hxx"
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <ostream>
+#include <unordered_set>
+
+namespace ifc::util {
+    namespace {
+        // Count the sorts of the abstract references over S in the heap.  The counts are spread
+        // over four sets of counters, so that consecutive increments do not wait on one another.
+        template<typename S>
+        std::vector<SortCount> count_sorts(gsl::span<const uint32_t> words)
+        {
+            constexpr uint32_t mask = (1u << index_like::tag_precision<S>) - 1;
+            std::array<std::array<uint64_t, mask + 1>, 4> counts{};
+            const auto size = words.size();
+            std::size_t i   = 0;
+            for (; i + 4 <= size; i += 4)
+            {
+                ++counts[0][words[i] & mask];
+                ++counts[1][words[i + 1] & mask];
+                ++counts[2][words[i + 2] & mask];
+                ++counts[3][words[i + 3] & mask];
+            }
+            for (; i < size; ++i)
+                ++counts[0][words[i] & mask];
+
+            std::vector<SortCount> result;
+            for (uint32_t s = 0; s <= mask; ++s)
+            {
+                const auto count = counts[0][s] + counts[1][s] + counts[2][s] + counts[3][s];
+                if (count == 0)
+                    continue;
+                const bool valid = s < ifc::to_underlying(S::Count);
+                result.push_back({valid ? sort_name(S(s)) : "(invalid sort)", count});
+            }
+            std::stable_sort(result.begin(), result.end(),
+                             [](const SortCount& a, const SortCount& b) { return a.count > b.count; });
+            return result;
+        }
+
+        struct HeapCounter {
+            HeapSort heap;
+            std::vector<SortCount> (*count)(gsl::span<const uint32_t>);
+        };
+
+        // clang-format off
+        // The heaps of abstract references.  The word and specialization form heaps hold other data.
+        constexpr HeapCounter heap_counters[] = {
+            {HeapSort::Decl,   count_sorts<DeclSort>},
+            {HeapSort::Type,   count_sorts<TypeSort>},
+            {HeapSort::Stmt,   count_sorts<StmtSort>},
+            {HeapSort::Expr,   count_sorts<ExprSort>},
+            {HeapSort::Syntax, count_sorts<SyntaxSort>},
+            {HeapSort::Chart,  count_sorts<ChartSort>},
+            {HeapSort::Form,   count_sorts<FormSort>},
+            {HeapSort::Attr,   count_sorts<AttrSort>},
+            {HeapSort::Dir,    count_sorts<DirSort>},
+        };
+        // clang-format on
+
+        StringTableStats string_table_stats(const Reader& reader)
+        {
+            // An IFC without a string table has no strings to count.
+            const auto* table = reader.ifc.string_table();
+            if (table == nullptr or table->empty())
+                return {};
+            const std::string_view chars{reinterpret_cast<const char*>(table->data()), table->size()};
+
+            StringTableStats stats;
+            stats.bytes = chars.size();
+            std::unordered_set<std::string_view> distinct;
+            for (std::size_t start = 0; start < chars.size();)
+            {
+                auto end = chars.find('\0', start);
+                if (end == std::string_view::npos)
+                    end = chars.size();
+                const auto str = chars.substr(start, end - start);
+                ++stats.strings;
+                if (not distinct.insert(str).second)
+                    stats.duplicate_bytes += str.size() + 1;
+                start = end + 1;
+            }
+            stats.distinct = distinct.size();
+            return stats;
+        }
+
+        std::string name_of(const Reader& reader, NameIndex name)
+        {
+            if (index_like::null(name))
+                return "(anonymous)";
+            if (name.sort() == NameSort::Identifier)
+                return reader.get(TextOffset(ifc::to_underlying(name.index())));
+            return std::string{"("} + sort_name(name.sort()) + ")";
+        }
+
+        // Name of the scope declaration, qualified by the names of the enclosing scope declarations.
+        std::string qualified_name(const Reader& reader, const symbolic::ScopeDecl& decl)
+        {
+            auto name = name_of(reader, decl.identity.name);
+            auto home = decl.home_scope;
+            // The bound guards against a malformed IFC in which scopes enclose one another.
+            for (int depth = 0; depth < 64 and not index_like::null(home) and home.sort() == DeclSort::Scope; ++depth)
+            {
+                const auto& enclosing = reader.get<symbolic::ScopeDecl>(home);
+                name = name_of(reader, enclosing.identity.name) + "::" + name;
+                home = enclosing.home_scope;
+            }
+            return name;
+        }
+
+        std::vector<ScopeSize> largest_scopes(const Reader& reader, std::size_t top)
+        {
+            // Only the positions are kept until the top ones are known: naming is the slow part.
+            std::vector<std::pair<uint32_t, const symbolic::ScopeDecl*>> sizes;
+            uint32_t global_members = 0;
+            if (const auto* global = reader.try_get(reader.ifc.header()->global_scope))
+                global_members = ifc::to_underlying(global->cardinality);
+            sizes.emplace_back(global_members, nullptr);
+            for (const auto& decl : reader.partition<symbolic::ScopeDecl>())
+            {
+                if (const auto* scope = reader.try_get(decl.initializer))
+                    sizes.emplace_back(ifc::to_underlying(scope->cardinality), &decl);
+            }
+
+            top = std::min(top, sizes.size());
+            std::partial_sort(sizes.begin(), sizes.begin() + static_cast<std::ptrdiff_t>(top), sizes.end(),
+                              [](const auto& a, const auto& b) { return a.first > b.first; });
+
+            std::vector<ScopeSize> result;
+            for (std::size_t i = 0; i < top; ++i)
+            {
+                const auto [members, decl] = sizes[i];
+                result.push_back({decl == nullptr ? "(global)" : qualified_name(reader, *decl), members});
+            }
+            return result;
+        }
+
+        double percent(uint64_t part, uint64_t whole)
+        {
+            return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+        }
+    } // namespace
+
+    IfcStats compute_stats(Reader& reader, std::size_t top_scopes)
+    {
+        IfcStats stats;
+        stats.file_bytes = reader.ifc.contents().size();
+
+        for (const auto& summary : reader.ifc.partition_table())
+        {
+            const auto count      = ifc::to_underlying(summary.cardinality);
+            const auto entry_size = ifc::to_underlying(summary.entry_size);
+            stats.partitions.push_back({reader.get(summary.name), count, entry_size, uint64_t{count} * entry_size});
+        }
+        std::stable_sort(stats.partitions.begin(), stats.partitions.end(),
+                         [](const PartitionStats& a, const PartitionStats& b) { return a.bytes > b.bytes; });
+
+        const auto& toc = reader.table_of_contents();
+        for (const auto& counter : heap_counters)
+        {
+            const auto& summary = toc[counter.heap];
+            if (summary.empty() or ifc::to_underlying(summary.entry_size) != sizeof(uint32_t))
+                continue;
+            stats.heaps.push_back({sort_name(counter.heap), counter.count(reader.ifc.view_partition<uint32_t>(summary))});
+        }
+
+        stats.strings        = string_table_stats(reader);
+        const CanonicalTypes types{reader};
+        stats.type_records   = types.records();
+        stats.distinct_types = types.size() - 1; // without the null type
+        stats.largest_scopes = largest_scopes(reader, top_scopes);
+        return stats;
+    }
+
+    void print_stats(const IfcStats& stats, std::ostream& out)
+    {
+        const auto flags = out.flags();
+        out << std::fixed << std::setprecision(1);
+        out << "file: " << stats.file_bytes << " bytes\n";
+
+        out << "\npartitions:\n";
+        for (const auto& p : stats.partitions)
+        {
+            out << "  " << std::left << std::setw(32) << p.name << std::right << std::setw(12) << p.bytes
+                << " bytes" << std::setw(10) << p.count << " x " << std::setw(3) << p.entry_size << std::setw(7)
+                << percent(p.bytes, stats.file_bytes) << "%\n";
+        }
+
+        const auto& strings = stats.strings;
+        out << "\nstring table: " << strings.bytes << " bytes (" << percent(strings.bytes, stats.file_bytes)
+            << "%), " << strings.strings << " strings, " << strings.distinct << " distinct, "
+            << strings.duplicate_bytes << " bytes in repetitions (" << percent(strings.duplicate_bytes, strings.bytes)
+            << "%)\n";
+
+        out << "\ntypes: " << stats.type_records << " records, " << stats.distinct_types << " distinct ("
+            << percent(stats.distinct_types, stats.type_records) << "%)\n";
+
+        for (const auto& heap : stats.heaps)
+        {
+            uint64_t total = 0;
+            for (const auto& s : heap.sorts)
+                total += s.count;
+            out << '\n' << heap.heap << ": " << total << " references\n";
+            for (const auto& s : heap.sorts)
+                out << "  " << std::left << std::setw(32) << s.sort << std::right << std::setw(12) << s.count
+                    << std::setw(7) << percent(s.count, total) << "%\n";
+        }
+
+        out << "\nlargest scopes:\n";
+        for (const auto& scope : stats.largest_scopes)
+            out << "  " << std::setw(10) << scope.members << "  " << scope.name << '\n';
+        out.flags(flags);
+    }
+} // namespace ifc::util
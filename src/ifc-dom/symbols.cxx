@@ -0,0 +1,584 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "ifc/dom/symbols.hxx"
+#include "ifc/dom/grep.hxx"
+#include "ifc/dom/modules.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#ifdef WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace ifc::util {
+    namespace fs = std::filesystem;
+
+    namespace {
+        // The sections of the index follow the header, each aligned on 8 bytes: the files, the
+        // names sorted by text, the text of the paths and names, and the postings.
+        struct IndexHeader {
+            char signature[16];
+            uint32_t file_count;
+            uint32_t name_count;
+            uint64_t files;
+            uint64_t names;
+            uint64_t strings;
+            uint64_t postings;
+            uint64_t size; // of the whole index
+        };
+
+        constexpr char index_signature[sizeof IndexHeader::signature] = "ifc-symbols 1";
+
+        struct FileRecord {
+            SHA256Hash content_hash;
+            uint64_t path;   // offsets in the strings
+            uint64_t module;
+            uint32_t path_length;
+            uint32_t module_length;
+        };
+
+        // The postings of a name are, for each declaration: the difference of its file with that
+        // of the previous one, its declaration key, less that of the previous one if in the
+        // same file, and the position of its qualified name in the names.
+        struct NameRecord {
+            uint64_t text;     // offset in the strings
+            uint64_t postings; // offset in the postings
+            uint32_t length;
+            uint32_t count;
+        };
+
+        uint64_t decl_key(DeclIndex decl)
+        {
+            return uint64_t{ifc::to_underlying(decl.index())} << 8 | ifc::to_underlying(decl.sort());
+        }
+
+        bool is_decl_key(uint64_t key)
+        {
+            return (key & 0xFF) < ifc::to_underlying(DeclSort::Count)
+                   and (key >> 8) >> index_like::index_precision<DeclSort> == 0;
+        }
+
+        DeclIndex decl_of(uint64_t key)
+        {
+            return index_like::make<DeclIndex>(DeclSort(key & 0xFF), static_cast<uint32_t>(key >> 8));
+        }
+
+        void append_varint(std::string& out, uint64_t n)
+        {
+            while (n >= 0x80)
+            {
+                out.push_back(static_cast<char>((n & 0x7F) | 0x80));
+                n >>= 7;
+            }
+            out.push_back(static_cast<char>(n));
+        }
+
+        uint64_t read_varint(const std::byte*& cursor, const std::byte* last)
+        {
+            uint64_t n = 0;
+            for (int shift = 0; cursor != last and shift < 64; shift += 7)
+            {
+                const auto b = std::to_integer<uint64_t>(*cursor++);
+                n |= (b & 0x7F) << shift;
+                if ((b & 0x80) == 0)
+                    return n;
+            }
+            throw "corrupted symbol index";
+        }
+
+        struct Posting {
+            uint32_t name; // identifier or qualified name
+            uint32_t file;
+            uint64_t key;
+            uint32_t qualified;
+
+            auto operator<=>(const Posting&) const = default;
+        };
+
+        // The sections of a mapped index, checked against its size.
+        struct IndexView {
+            const IndexHeader* header = nullptr;
+            gsl::span<const FileRecord> files;
+            gsl::span<const NameRecord> names;
+            std::string_view strings;
+            gsl::span<const std::byte> postings;
+
+            explicit IndexView(gsl::span<const std::byte> bytes)
+            {
+                if (bytes.size() < sizeof(IndexHeader))
+                    throw "not a symbol index";
+                header = reinterpret_cast<const IndexHeader*>(bytes.data());
+                if (std::memcmp(header->signature, index_signature, sizeof index_signature) != 0)
+                    throw "not a symbol index";
+                const auto& h = *header;
+                if (h.size != bytes.size() or h.files > h.names or h.names > h.strings or h.strings > h.postings
+                    or h.postings > h.size or (h.names - h.files) / sizeof(FileRecord) < h.file_count
+                    or (h.strings - h.names) / sizeof(NameRecord) < h.name_count)
+                    throw "corrupted symbol index";
+                files    = {reinterpret_cast<const FileRecord*>(bytes.data() + h.files), h.file_count};
+                names    = {reinterpret_cast<const NameRecord*>(bytes.data() + h.names), h.name_count};
+                strings  = {reinterpret_cast<const char*>(bytes.data() + h.strings), h.postings - h.strings};
+                postings = bytes.subspan(h.postings);
+            }
+
+            std::string_view text(uint64_t offset, uint32_t length) const
+            {
+                if (offset > strings.size() or length > strings.size() - offset)
+                    throw "corrupted symbol index";
+                return strings.substr(offset, length);
+            }
+
+            std::string_view text(const NameRecord& name) const
+            {
+                return text(name.text, name.length);
+            }
+
+            // Call f(file, key, qualified) on each posting of the name.
+            template<typename F>
+            void for_each_posting(const NameRecord& name, F f) const
+            {
+                if (name.postings > postings.size())
+                    throw "corrupted symbol index";
+                const auto* cursor = postings.data() + name.postings;
+                const auto* last   = postings.data() + postings.size();
+                uint64_t file      = 0;
+                uint64_t key       = 0;
+                for (uint32_t i = 0; i < name.count; ++i)
+                {
+                    const auto file_delta = read_varint(cursor, last);
+                    file += file_delta;
+                    key = (file_delta == 0 and i != 0 ? key : 0) + read_varint(cursor, last);
+                    const auto qualified = read_varint(cursor, last);
+                    if (file >= files.size() or qualified >= names.size() or not is_decl_key(key))
+                        throw "corrupted symbol index";
+                    f(static_cast<uint32_t>(file), key, static_cast<uint32_t>(qualified));
+                }
+            }
+        };
+
+        std::optional<SHA256Hash> read_content_hash(const fs::path& path)
+        {
+            std::ifstream stream{path, std::ios_base::binary};
+            char signature[sizeof InterfaceSignature];
+            Header header;
+            if (not stream.read(signature, sizeof signature)
+                or std::memcmp(signature, InterfaceSignature, sizeof signature) != 0
+                or not stream.read(reinterpret_cast<char*>(&header), sizeof header))
+                return std::nullopt;
+            return header.content_hash;
+        }
+
+        // The .ifc files in the directories, each once, by path.
+        std::vector<fs::path> find_ifcs(const std::vector<fs::path>& directories)
+        {
+            std::set<fs::path> found;
+            for (const auto& directory : directories)
+            {
+                std::error_code error;
+                fs::recursive_directory_iterator it{directory, fs::directory_options::skip_permission_denied, error};
+                for (; not error and it != fs::recursive_directory_iterator{}; it.increment(error))
+                {
+                    if (it->path().extension() == ".ifc" and it->is_regular_file(error))
+                        found.insert(it->path().lexically_normal());
+                }
+            }
+            return {found.begin(), found.end()};
+        }
+
+        // A file of the new index, as found in the previous one or read.
+        struct IngestedFile {
+            fs::path path;
+            SHA256Hash content_hash{};
+            std::string module;
+            std::optional<uint32_t> previous; // position in the previous index
+            std::vector<DeclaredName> names;
+            bool failed = false;
+        };
+
+        class IndexWriter {
+        public:
+            uint32_t name(std::string_view text)
+            {
+                auto [it, inserted] = ids.try_emplace(std::string{text}, static_cast<uint32_t>(texts.size()));
+                if (inserted)
+                    texts.push_back(&it->first);
+                return it->second;
+            }
+
+            void add(uint32_t name, uint32_t file, uint64_t key, uint32_t qualified)
+            {
+                postings.push_back({name, file, key, qualified});
+            }
+
+            void write(std::ostream& out, const std::vector<IngestedFile>& files)
+            {
+                // Number the names in the order of their text.
+                std::vector<uint32_t> order(texts.size());
+                for (uint32_t i = 0; i < order.size(); ++i)
+                    order[i] = i;
+                std::ranges::sort(order, {}, [&](uint32_t i) -> const std::string& { return *texts[i]; });
+                std::vector<uint32_t> rank(texts.size());
+                for (uint32_t i = 0; i < order.size(); ++i)
+                    rank[order[i]] = i;
+                for (auto& p : postings)
+                {
+                    p.name      = rank[p.name];
+                    p.qualified = rank[p.qualified];
+                }
+                std::ranges::sort(postings);
+                postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+
+                std::string strings;
+                std::vector<FileRecord> file_records;
+                for (const auto& file : files)
+                {
+                    const auto path = file.path.generic_u8string();
+                    FileRecord record{file.content_hash, strings.size(), 0, static_cast<uint32_t>(path.size()),
+                                      static_cast<uint32_t>(file.module.size())};
+                    strings.append(reinterpret_cast<const char*>(path.data()), path.size());
+                    record.module = strings.size();
+                    strings.append(file.module);
+                    file_records.push_back(record);
+                }
+
+                std::vector<NameRecord> name_records;
+                std::string encoded;
+                auto p = postings.begin();
+                for (auto i : order)
+                {
+                    NameRecord record{strings.size(), encoded.size(), static_cast<uint32_t>(texts[i]->size()), 0};
+                    strings.append(*texts[i]);
+                    const auto id = static_cast<uint32_t>(name_records.size());
+                    for (uint32_t file = 0; p != postings.end() and p->name == id; ++p, ++record.count)
+                    {
+                        const bool same_file = record.count != 0 and p->file == file;
+                        append_varint(encoded, p->file - (record.count != 0 ? file : 0));
+                        append_varint(encoded, same_file ? p->key - (p - 1)->key : p->key);
+                        append_varint(encoded, p->qualified);
+                        file = p->file;
+                    }
+                    name_records.push_back(record);
+                }
+
+                auto aligned = [](uint64_t n) { return (n + 7) & ~uint64_t{7}; };
+                IndexHeader header{};
+                std::memcpy(header.signature, index_signature, sizeof index_signature);
+                header.file_count = static_cast<uint32_t>(file_records.size());
+                header.name_count = static_cast<uint32_t>(name_records.size());
+                header.files      = aligned(sizeof header);
+                header.names      = aligned(header.files + file_records.size() * sizeof(FileRecord));
+                header.strings    = aligned(header.names + name_records.size() * sizeof(NameRecord));
+                header.postings   = header.strings + strings.size();
+                header.size       = header.postings + encoded.size();
+
+                uint64_t position = 0;
+                auto put = [&](uint64_t offset, const void* data, std::size_t size) {
+                    for (; position < offset; ++position)
+                        out.put('\0');
+                    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                    position += size;
+                };
+                put(0, &header, sizeof header);
+                put(header.files, file_records.data(), file_records.size() * sizeof(FileRecord));
+                put(header.names, name_records.data(), name_records.size() * sizeof(NameRecord));
+                put(header.strings, strings.data(), strings.size());
+                put(header.postings, encoded.data(), encoded.size());
+            }
+
+        private:
+            std::unordered_map<std::string, uint32_t> ids;
+            std::vector<const std::string*> texts; // by id; the keys of the map do not move
+            std::vector<Posting> postings;
+        };
+    } // namespace
+
+    struct SymbolIndex::Mapping {
+#ifdef WIN32
+        HANDLE file    = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+        const std::byte* data = nullptr;
+        std::size_t size      = 0;
+        std::optional<IndexView> view;
+
+        explicit Mapping(const fs::path& path)
+        {
+#ifdef WIN32
+            file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+            LARGE_INTEGER length{};
+            if (file == INVALID_HANDLE_VALUE or not GetFileSizeEx(file, &length) or length.QuadPart == 0)
+                throw IfcReadFailure{Pathname{path.u8string()}};
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+                data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            size = static_cast<std::size_t>(length.QuadPart);
+#else
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat status{};
+            if (fd < 0 or ::fstat(fd, &status) != 0 or status.st_size == 0)
+            {
+                if (fd >= 0)
+                    ::close(fd);
+                throw IfcReadFailure{Pathname{path.u8string()}};
+            }
+            size       = static_cast<std::size_t>(status.st_size);
+            void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (base != MAP_FAILED)
+                data = static_cast<const std::byte*>(base);
+#endif
+            if (data == nullptr)
+            {
+                release();
+                throw IfcReadFailure{Pathname{path.u8string()}};
+            }
+            try
+            {
+                view.emplace(gsl::span<const std::byte>{data, size});
+            }
+            catch (...)
+            {
+                release();
+                throw;
+            }
+        }
+
+        ~Mapping()
+        {
+            release();
+        }
+
+        void release()
+        {
+#ifdef WIN32
+            if (data != nullptr)
+                UnmapViewOfFile(data);
+            if (mapping != nullptr)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            mapping = nullptr;
+            file    = INVALID_HANDLE_VALUE;
+#else
+            if (data != nullptr)
+                ::munmap(const_cast<std::byte*>(data), size);
+#endif
+            data = nullptr;
+        }
+    };
+
+    SymbolIndex::SymbolIndex(const fs::path& file) : mapping(std::make_unique<Mapping>(file)) {}
+
+    SymbolIndex::~SymbolIndex() = default;
+
+    std::size_t SymbolIndex::file_count() const
+    {
+        return mapping->view->files.size();
+    }
+
+    std::size_t SymbolIndex::name_count() const
+    {
+        return mapping->view->names.size();
+    }
+
+    std::vector<SymbolPosting> SymbolIndex::find(std::string_view name) const
+    {
+        if (name.starts_with("::"))
+            name.remove_prefix(2);
+        const auto& view = *mapping->view;
+        std::vector<SymbolPosting> result;
+        auto it = std::ranges::lower_bound(view.names, name, {},
+                                           [&](const NameRecord& record) { return view.text(record); });
+        if (it == view.names.end() or view.text(*it) != name)
+            return result;
+        view.for_each_posting(*it, [&](uint32_t file, uint64_t key, uint32_t qualified) {
+            const auto& record = view.files[file];
+            result.push_back({view.text(record.path, record.path_length), view.text(record.module, record.module_length),
+                              view.text(view.names[qualified]), decl_of(key)});
+        });
+        return result;
+    }
+
+    SymbolIndexUpdate build_symbol_index(const std::vector<fs::path>& directories, const fs::path& file,
+                                         unsigned jobs)
+    {
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+
+        // The previous index, if any, and the positions of its files by content hash.
+        std::unique_ptr<SymbolIndex> previous;
+        std::map<std::array<uint32_t, 8>, uint32_t> by_hash;
+        std::error_code error;
+        if (fs::exists(file, error))
+        {
+            try
+            {
+                previous = std::make_unique<SymbolIndex>(file);
+            }
+            catch (...)
+            {
+                // An index of another version, or damaged, is built anew.
+            }
+        }
+        if (previous != nullptr)
+        {
+            const auto& files = previous->mapping->view->files;
+            for (uint32_t i = 0; i < files.size(); ++i)
+                by_hash.try_emplace(files[i].content_hash.value, i);
+        }
+
+        SymbolIndexUpdate update;
+        std::vector<IngestedFile> files;
+        for (auto& path : find_ifcs(directories))
+            files.emplace_back().path = std::move(path);
+        update.scanned = files.size();
+
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> read{0};
+        std::mutex mutex;
+        std::exception_ptr failure;
+        auto work = [&] {
+            try
+            {
+                for (auto i = next++; i < files.size(); i = next++)
+                {
+                    auto& ingested    = files[i];
+                    const auto hash   = read_content_hash(ingested.path);
+                    ingested.failed   = not hash;
+                    if (not hash)
+                        continue;
+                    ingested.content_hash = *hash;
+                    if (auto known = by_hash.find(hash->value); known != by_hash.end())
+                    {
+                        ingested.previous = known->second;
+                        continue;
+                    }
+                    ++read;
+                    try
+                    {
+                        const auto module = load_module(ingested.path);
+                        ingested.module   = to_string(module->name);
+                        ingested.names    = declared_names(module->reader());
+                    }
+                    catch (...)
+                    {
+                        ingested.failed = true;
+                    }
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard lock{mutex};
+                if (not failure)
+                    failure = std::current_exception();
+                next = files.size();
+            }
+        };
+        {
+            std::vector<std::jthread> workers;
+            const auto n = std::min<std::size_t>(jobs, files.size());
+            for (std::size_t i = 0; i < n; ++i)
+                workers.emplace_back(work);
+        }
+        if (failure)
+            std::rethrow_exception(failure);
+        update.read = read;
+
+        // Files that could not be read are left out of the index.
+        for (const auto& ingested : files)
+        {
+            if (ingested.failed)
+                update.failed.push_back(ingested.path);
+        }
+        std::erase_if(files, [](const IngestedFile& ingested) { return ingested.failed; });
+
+        IndexWriter writer;
+        std::vector<std::vector<uint32_t>> reused; // positions in the new index, by position in the previous one
+        for (uint32_t i = 0; i < files.size(); ++i)
+        {
+            auto& ingested = files[i];
+            if (ingested.previous)
+            {
+                const auto& view   = *previous->mapping->view;
+                const auto& record = view.files[*ingested.previous];
+                ingested.module    = view.text(record.module, record.module_length);
+                reused.resize(view.files.size());
+                reused[*ingested.previous].push_back(i);
+                continue;
+            }
+            for (const auto& declared : ingested.names)
+            {
+                const auto qualified = writer.name(declared.name);
+                writer.add(qualified, i, decl_key(declared.decl), qualified);
+                writer.add(writer.name(declared.identifier), i, decl_key(declared.decl), qualified);
+            }
+            ingested.names.clear();
+        }
+
+        if (previous != nullptr)
+        {
+            // The postings of the files still there are taken from the previous index, one name at a
+            // time.
+            const auto& view = *previous->mapping->view;
+            std::vector<uint32_t> ids(view.names.size(), UINT32_MAX);
+            auto id_of = [&](uint32_t position) {
+                if (ids[position] == UINT32_MAX)
+                    ids[position] = writer.name(view.text(view.names[position]));
+                return ids[position];
+            };
+            if (not reused.empty())
+            {
+                for (uint32_t n = 0; n < view.names.size(); ++n)
+                {
+                    view.for_each_posting(view.names[n], [&](uint32_t old_file, uint64_t key, uint32_t qualified) {
+                        for (auto new_file : reused[old_file])
+                            writer.add(id_of(n), new_file, key, id_of(qualified));
+                    });
+                }
+            }
+
+            std::set<fs::path> paths;
+            for (const auto& ingested : files)
+                paths.insert(ingested.path);
+            for (const auto& record : view.files)
+            {
+                const auto text = view.text(record.path, record.path_length);
+                if (not paths.contains(fs::path{std::u8string{text.begin(), text.end()}}))
+                    ++update.removed;
+            }
+        }
+
+        // Write aside, then replace, so that a concurrent query never sees half an index.
+        auto temporary = file;
+        temporary += ".tmp";
+        {
+            std::ofstream stream{temporary, std::ios_base::binary | std::ios_base::trunc};
+            writer.write(stream, files);
+            if (not stream.flush())
+                throw "couldn't write the symbol index";
+        }
+        previous.reset();
+        fs::rename(temporary, file);
+        return update;
+    }
+} // namespace ifc::util
@@ -7,161 +7,192 @@ namespace ifc::util {
     // Try to produce a short string for an type, if possible.
 
     namespace {
+        // Appends the short string for a type to `out`, which is the render buffer of the loader.
+        // Nothing is appended if the type has no short form.
         struct TypeTranslator {
             Loader& ctx;
+            std::string& out;
 
-            std::string operator()(const symbolic::FundamentalType& type)
+            template<index_like::MultiSorted Index>
+            void ref(Index index)
             {
-                return to_string(type);
+                ctx.append_ref(out, index);
             }
 
-            std::string operator()(const symbolic::DesignatedType& as_type)
+            void operator()(const symbolic::FundamentalType& type)
+            {
+                out.append(to_string(type));
+            }
+
+            void operator()(const symbolic::DesignatedType& as_type)
             {
-                std::string result("decl-type(");
-                result.append(ctx.ref(as_type.decl));
-                result.push_back(')');
-                return result;
+                out.append("decl-type(");
+                ref(as_type.decl);
+                out.push_back(')');
             }
 
-            std::string operator()(const symbolic::SyntacticType& type)
+            void operator()(const symbolic::SyntacticType& type)
             {
-                std::string result("syntactic-type(");
-                result.append(ctx.ref(type.expr));
-                result.push_back(')');
-                return result;
+                out.append("syntactic-type(");
+                ref(type.expr);
+                out.push_back(')');
             }
 
-            std::string operator()(const symbolic::ExpansionType& type)
+            void operator()(const symbolic::ExpansionType& type)
             {
-                return ctx.ref(type.pack) + to_string(type.mode);
+                ref(type.pack);
+                out.append(to_string(type.mode));
             }
 
-            std::string operator()(const symbolic::PointerType& ptr)
+            void operator()(const symbolic::PointerType& ptr)
             {
-                return ctx.ref(ptr.pointee) + "*";
+                ref(ptr.pointee);
+                out.push_back('*');
             }
 
-            std::string operator()(const symbolic::PointerToMemberType& ptr)
+            void operator()(const symbolic::PointerToMemberType& ptr)
             {
-                return ctx.ref(ptr.type) + " " + ctx.ref(ptr.scope) + "::*";
+                ref(ptr.type);
+                out.push_back(' ');
+                ref(ptr.scope);
+                out.append("::*");
             }
 
-            std::string operator()(const symbolic::LvalueReferenceType& type)
+            void operator()(const symbolic::LvalueReferenceType& type)
             {
-                return ctx.ref(type.referee) + "&";
+                ref(type.referee);
+                out.push_back('&');
             }
-            std::string operator()(const symbolic::RvalueReferenceType& type)
+            void operator()(const symbolic::RvalueReferenceType& type)
             {
-                return ctx.ref(type.referee) + "&&";
+                ref(type.referee);
+                out.append("&&");
             }
-            std::string operator()(const symbolic::FunctionType& type)
+            void operator()(const symbolic::FunctionType& type)
             {
                 // int(int,int)
-                std::string result(ctx.ref(type.target));
-                result.push_back('(');
-                result.append(ctx.ref(type.source));
-                result.push_back(')');
-                // TODO: util::append_misc(result, type.eh_spec, type.convention, type.traits);
-                return result;
+                ref(type.target);
+                out.push_back('(');
+                ref(type.source);
+                out.push_back(')');
+                // TODO: util::append_misc(out, type.eh_spec, type.convention, type.traits);
             }
 
-            std::string operator()(const symbolic::MethodType& type)
+            void operator()(const symbolic::MethodType& type)
             {
                 // int(MyClass: int,int)
-                std::string result(ctx.ref(type.target));
-                result.push_back('(');
-                result.append(ctx.ref(type.class_type));
-                result.append(": ");
-                result.append(ctx.ref(type.source));
-                result.push_back(')');
-                // TODO: util::append_misc(result, type.eh_spec, type.convention, type.traits);
-                return result;
+                ref(type.target);
+                out.push_back('(');
+                ref(type.class_type);
+                out.append(": ");
+                ref(type.source);
+                out.push_back(')');
+                // TODO: util::append_misc(out, type.eh_spec, type.convention, type.traits);
             }
 
-            std::string operator()(const symbolic::ArrayType& arr)
+            void operator()(const symbolic::ArrayType& arr)
             {
-                return ctx.ref(arr.element) + '[' + ctx.ref(arr.bound) + ']';
+                ref(arr.element);
+                out.push_back('[');
+                ref(arr.bound);
+                out.push_back(']');
             }
-            std::string operator()(const symbolic::TypenameType& unresolved_type)
+            void operator()(const symbolic::TypenameType& unresolved_type)
             {
-                return "typename " + ctx.ref(unresolved_type.path);
+                out.append("typename ");
+                ref(unresolved_type.path);
             }
-            std::string operator()(const symbolic::QualifiedType& qual)
+            void operator()(const symbolic::QualifiedType& qual)
             {
-                return ctx.ref(qual.unqualified_type) + " " + to_string(qual.qualifiers);
+                ref(qual.unqualified_type);
+                out.push_back(' ');
+                out.append(to_string(qual.qualifiers));
             }
 
-            std::string operator()(const symbolic::BaseType& base)
+            void operator()(const symbolic::BaseType& base)
             {
-                std::string result = ctx.ref(base.type);
+                out.append(to_string(base.access));
+                out.push_back(' ');
                 if (base.traits == symbolic::BaseClassTraits::Shared)
-                    result = "virtual " + result;
+                    out.append("virtual ");
+                ref(base.type);
                 if (base.traits == symbolic::BaseClassTraits::Expanded)
-                    result = result + "...";
-                return to_string(base.access) + " " + result;
+                    out.append("...");
             }
 
-            std::string operator()(const symbolic::DecltypeType& val)
+            void operator()(const symbolic::DecltypeType& val)
             {
-                return "decltype(" + ctx.ref(val.expression) + ")";
+                out.append("decltype(");
+                ref(val.expression);
+                out.push_back(')');
             }
 
-            std::string operator()(const symbolic::PlaceholderType& type)
+            void operator()(const symbolic::PlaceholderType& type)
             {
-                std::string result = "type-placeholder(" + to_string(type.basis);
+                out.append("type-placeholder(");
+                out.append(to_string(type.basis));
                 if (not null(type.elaboration))
-                    result += " " + ctx.ref(type.elaboration);
+                {
+                    out.push_back(' ');
+                    ref(type.elaboration);
+                }
                 if (not null(type.constraint))
-                    result.append(" " + ctx.ref(type.constraint));
-                result += ')';
-                return result;
+                {
+                    out.push_back(' ');
+                    ref(type.constraint);
+                }
+                out.push_back(')');
             }
 
-            std::string operator()(const symbolic::TupleType& tuple)
+            void operator()(const symbolic::TupleType& tuple)
             {
-                std::string result;
+                bool first = true;
                 for (auto& index : ctx.reader.sequence(tuple))
                 {
-                    if (not result.empty())
-                        result.push_back(',');
-                    result.append(ctx.ref(index));
+                    if (not first)
+                        out.push_back(',');
+                    ref(index);
+                    first = false;
                 }
-                return result;
             }
 
-            std::string operator()(const symbolic::ForallType&)
-            {
-                return "";
-            }
+            void operator()(const symbolic::ForallType&) {}
 
-            std::string operator()(const symbolic::UnalignedType& type)
+            void operator()(const symbolic::UnalignedType& type)
             {
-                return "__unaligned " + ctx.ref(type.operand);
+                out.append("__unaligned ");
+                ref(type.operand);
             }
 
-            std::string operator()(const symbolic::SyntaxTreeType& syntax)
+            void operator()(const symbolic::SyntaxTreeType& syntax)
             {
-                return "syntax-tree(" + ctx.ref(syntax.syntax) + ")";
+                out.append("syntax-tree(");
+                ref(syntax.syntax);
+                out.push_back(')');
             }
 
-            std::string operator()(const symbolic::TorType& type)
+            void operator()(const symbolic::TorType& type)
             {
                 // #TOR(int, float)
-                std::string result("#TOR(");
-                result.append(ctx.ref(type.source));
-                result.push_back(')');
-                // TODO: util::append_misc(result, type.eh_spec, type.convention);
-                return result;
+                out.append("#TOR(");
+                ref(type.source);
+                out.push_back(')');
+                // TODO: util::append_misc(out, type.eh_spec, type.convention);
             }
         };
 
     } // namespace
 
+    std::string_view short_string(Loader& ctx, TypeIndex index)
+    {
+        if (null(index))
+            return "no-type";
+        return ctx.render(index, [&](std::string& out) { ctx.reader.visit(index, TypeTranslator{ctx, out}); });
+    }
+
     std::string get_string_if_possible(Loader& ctx, TypeIndex index)
     {
-        if (not null(index))
-            return ctx.reader.visit(index, TypeTranslator{ctx});
-        return "no-type";
+        return std::string(short_string(ctx, index));
     }
 
     // Load types as full blown nodes.
@@ -0,0 +1,246 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "printer.hxx"
+
+namespace ifc::util {
+    namespace {
+        constexpr uint64_t reference_bit = uint64_t{1} << 63;
+
+        uint64_t pack(NodeKey key)
+        {
+            return uint64_t{ifc::to_underlying(key.kind())} << 48 | uint64_t{key.sort()} << 32 | key.index();
+        }
+
+        // Write the string, with the characters that are special in the format escaped.
+        void write_escaped(OutputBuffer& out, std::string_view str, OutputFormat format)
+        {
+            size_t start = 0;
+            for (size_t i = 0; i < str.size(); ++i)
+            {
+                std::string_view escape;
+                switch (str[i])
+                {
+                case '"':
+                    escape = format == OutputFormat::Dot ? "\\\"" : "&quot;";
+                    break;
+                case '\\':
+                    if (format == OutputFormat::Dot)
+                        escape = "\\\\";
+                    break;
+                case '\n':
+                    escape = format == OutputFormat::Dot ? "\\n" : "&#10;";
+                    break;
+                case '&':
+                    if (format == OutputFormat::GraphML)
+                        escape = "&amp;";
+                    break;
+                case '<':
+                    if (format == OutputFormat::GraphML)
+                        escape = "&lt;";
+                    break;
+                case '>':
+                    if (format == OutputFormat::GraphML)
+                        escape = "&gt;";
+                    break;
+                }
+                if (not escape.empty())
+                {
+                    out << str.substr(start, i - start) << escape;
+                    start = i + 1;
+                }
+            }
+            out << str.substr(start);
+        }
+
+        void write_key(OutputBuffer& out, NodeKey key)
+        {
+            char buf[format_buffer_size];
+            out << '"' << std::string_view{buf, format_to(buf, key)} << '"';
+        }
+    } // namespace
+
+    GraphWriter::GraphWriter(OutputBuffer& out_, OutputFormat format_, const GraphOptions& options_)
+      : out(out_), format(format_), options(options_)
+    {}
+
+    void GraphWriter::begin_file(std::string_view path)
+    {
+        visited.clear();
+        written.clear();
+        edges.clear();
+        references.clear();
+
+        if (format == OutputFormat::Dot)
+        {
+            out << "digraph \"";
+            write_escaped(out, path, format);
+            out << "\" {\n";
+            return;
+        }
+
+        if (first_file)
+        {
+            out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+                   "<key id=\"label\" for=\"node\" attr.name=\"label\" attr.type=\"string\"/>\n"
+                   "<key id=\"kind\" for=\"node\" attr.name=\"kind\" attr.type=\"string\"/>\n"
+                   "<key id=\"reference\" for=\"edge\" attr.name=\"reference\" attr.type=\"boolean\"/>\n";
+        }
+        first_file = false;
+        out << "<graph id=\"";
+        write_escaped(out, path, format);
+        out << "\" edgedefault=\"directed\">\n";
+    }
+
+    void GraphWriter::write(const Node& root)
+    {
+        work.push_back({&root, nullptr});
+        while (not work.empty())
+        {
+            const auto step = work.back();
+            work.pop_back();
+            if (step.node == nullptr)
+            {
+                close_cluster();
+                continue;
+            }
+
+            const auto& node = *step.node;
+            // A node reached again is drawn once, but with an edge from each of its parents.
+            if (step.parent != nullptr and written.contains(pack(node.key)))
+                write_edge(step.parent->key, node.key, false);
+            if (not visited.insert(&node).second)
+                continue;
+
+            // The parent of the children, in the graph.
+            const Node* parent = step.parent;
+            if (included(node))
+            {
+                if (written.size() == options.node_budget)
+                {
+                    // Nothing more fits: unwind the open clusters, and stop.
+                    for (; not work.empty(); work.pop_back())
+                    {
+                        if (work.back().node == nullptr)
+                            close_cluster();
+                    }
+                    return;
+                }
+
+                const bool cluster = options.cluster_scopes and node.key.kind() == SortKind::Scope;
+                if (cluster)
+                    work.push_back({nullptr, nullptr});
+                write_node(node, cluster);
+                if (step.parent != nullptr)
+                    write_edge(step.parent->key, node.key, false);
+                parent = &node;
+
+                for (const auto& key : node.references)
+                    references.emplace_back(node.key, key);
+            }
+
+            // Push in reverse, so that the children are written in order.
+            for (auto it = node.children.rbegin(); it != node.children.rend(); ++it)
+                work.push_back({*it, parent});
+        }
+    }
+
+    void GraphWriter::end_records()
+    {
+        for (const auto& [from, to] : references)
+        {
+            if (written.contains(pack(to)))
+                write_edge(from, to, true);
+        }
+        references.clear();
+    }
+
+    void GraphWriter::end_file()
+    {
+        out << (format == OutputFormat::Dot ? "}\n" : "</graph>\n");
+    }
+
+    void GraphWriter::finish()
+    {
+        if (format == OutputFormat::GraphML)
+        {
+            if (first_file)
+                out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n";
+            out << "</graphml>\n";
+        }
+    }
+
+    bool GraphWriter::included(const Node& node) const
+    {
+        return options.kinds.empty()
+               or std::find(options.kinds.begin(), options.kinds.end(), node.key.kind()) != options.kinds.end();
+    }
+
+    void GraphWriter::write_label(const Node& node)
+    {
+        write_escaped(out, node.id, format);
+        if (auto it = node.props.find("name"); it != node.props.end() and not it->second.empty())
+        {
+            write_escaped(out, "\n", format);
+            write_escaped(out, it->second, format);
+        }
+    }
+
+    // A scope node that starts a cluster is the first node in it.
+    void GraphWriter::write_node(const Node& node, bool cluster)
+    {
+        written.insert(pack(node.key));
+        char buf[format_buffer_size];
+        const std::string_view id{buf, format_to(buf, node.key)};
+        if (format == OutputFormat::Dot)
+        {
+            if (cluster)
+                out << "subgraph \"cluster_" << id << "\" {\n";
+            out << "  ";
+            write_key(out, node.key);
+            out << " [label=\"";
+            write_label(node);
+            out << "\"];\n";
+            return;
+        }
+
+        out << "<node id=";
+        write_key(out, node.key);
+        out << "><data key=\"kind\">" << to_string(node.key.kind()) << "</data><data key=\"label\">";
+        write_label(node);
+        out << "</data>";
+        if (cluster)
+            out << "\n<graph id=\"" << id << ":\" edgedefault=\"directed\">\n";
+        else
+            out << "</node>\n";
+    }
+
+    void GraphWriter::write_edge(NodeKey from, NodeKey to, bool reference)
+    {
+        if (not edges.insert({pack(from), pack(to) | (reference ? reference_bit : 0)}).second)
+            return;
+
+        if (format == OutputFormat::Dot)
+        {
+            out << "  ";
+            write_key(out, from);
+            out << " -> ";
+            write_key(out, to);
+            out << (reference ? " [style=dashed];\n" : ";\n");
+            return;
+        }
+
+        out << "<edge source=";
+        write_key(out, from);
+        out << " target=";
+        write_key(out, to);
+        out << (reference ? "><data key=\"reference\">true</data></edge>\n" : "/>\n");
+    }
+
+    void GraphWriter::close_cluster()
+    {
+        out << (format == OutputFormat::Dot ? "}\n" : "</graph></node>\n");
+    }
+} // namespace ifc::util
@@ -0,0 +1,258 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "printer.hxx"
+#include <cstring>
+
+namespace ifc::util {
+    namespace {
+        constexpr uint64_t ones  = 0x0101010101010101;
+        constexpr uint64_t highs = 0x8080808080808080;
+
+        // True if any of the eight bytes is below 0x20, or a quote, or a backslash, or
+        // not ASCII.  The checks are done on all the bytes of the word at once; a hit is
+        // then located byte by byte.
+        constexpr bool needs_escape(uint64_t word)
+        {
+            auto has_zero = [](uint64_t x) { return (x - ones) & ~x & highs; };
+            auto has_less = [](uint64_t x, uint64_t n) { return (x - ones * n) & ~x & highs; };
+            return (has_less(word, 0x20) | has_zero(word ^ (ones * '"')) | has_zero(word ^ (ones * '\\'))
+                    | (word & highs))
+                   != 0;
+        }
+
+        struct Utf8Sequence {
+            size_t length;
+            bool valid;
+        };
+
+        // The UTF-8 sequence at the start of the string, whose first byte is not ASCII.  If it
+        // is ill-formed, its length is that of its maximal subpart, which stands for one U+FFFD
+        // (see the Unicode Standard, 3.9).
+        Utf8Sequence utf8_sequence(std::string_view str)
+        {
+            const auto lead    = static_cast<unsigned char>(str[0]);
+            size_t length      = 0;
+            unsigned char low  = 0x80; // range of the second byte
+            unsigned char high = 0xBF;
+            if (lead >= 0xC2 and lead <= 0xDF)
+            {
+                length = 2;
+            }
+            else if (lead >= 0xE0 and lead <= 0xEF)
+            {
+                length = 3;
+                if (lead == 0xE0)
+                    low = 0xA0; // overlong
+                else if (lead == 0xED)
+                    high = 0x9F; // surrogate
+            }
+            else if (lead >= 0xF0 and lead <= 0xF4)
+            {
+                length = 4;
+                if (lead == 0xF0)
+                    low = 0x90; // overlong
+                else if (lead == 0xF4)
+                    high = 0x8F; // beyond U+10FFFF
+            }
+            else
+            {
+                return {1, false};
+            }
+
+            for (size_t i = 1; i < length; ++i)
+            {
+                if (i == str.size())
+                    return {i, false};
+                const auto byte = static_cast<unsigned char>(str[i]);
+                if (byte < low or byte > high)
+                    return {i, false};
+                low  = 0x80;
+                high = 0xBF;
+            }
+            return {length, true};
+        }
+
+        constexpr bool needs_escape(char c)
+        {
+            return static_cast<unsigned char>(c) < 0x20 or c == '"' or c == '\\';
+        }
+
+        void write_escape(OutputBuffer& out, char c)
+        {
+            switch (c)
+            {
+            case '"':
+                out << "\\\"";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            case '\n':
+                out << "\\n";
+                break;
+            case '\r':
+                out << "\\r";
+                break;
+            case '\t':
+                out << "\\t";
+                break;
+            default:
+                {
+                    constexpr char hex[] = "0123456789abcdef";
+                    const auto byte      = static_cast<unsigned char>(c);
+                    out << "\\u00" << hex[byte >> 4] << hex[byte & 0xF];
+                }
+                break;
+            }
+        }
+
+        void write_key(OutputBuffer& out, NodeKey key)
+        {
+            char buf[format_buffer_size];
+            out << '"' << std::string_view{buf, format_to(buf, key)} << '"';
+        }
+    } // namespace
+
+    void write_json_string(OutputBuffer& out, std::string_view str)
+    {
+        out << '"';
+        const char* const data = str.data();
+        const size_t size      = str.size();
+        size_t start           = 0; // first byte not written yet
+        size_t i               = 0;
+        while (i < size)
+        {
+            // Skip over runs of plain bytes a word at a time.
+            if (size - i >= sizeof(uint64_t))
+            {
+                uint64_t word;
+                std::memcpy(&word, data + i, sizeof word);
+                if (not needs_escape(word))
+                {
+                    i += sizeof word;
+                    continue;
+                }
+            }
+
+            const auto end = std::min(size, i + sizeof(uint64_t));
+            while (i < end)
+            {
+                if (static_cast<unsigned char>(data[i]) >= 0x80)
+                {
+                    // JSON text is UTF-8: what is not is written as replacement characters.
+                    const auto sequence = utf8_sequence(str.substr(i));
+                    if (not sequence.valid)
+                    {
+                        out << str.substr(start, i - start) << "\xEF\xBF\xBD";
+                        start = i + sequence.length;
+                    }
+                    i += sequence.length;
+                    continue;
+                }
+                if (needs_escape(data[i]))
+                {
+                    out << str.substr(start, i - start);
+                    write_escape(out, data[i]);
+                    start = i + 1;
+                }
+                ++i;
+            }
+        }
+        out << str.substr(start) << '"';
+    }
+
+    JsonWriter::JsonWriter(OutputBuffer& out_, OutputFormat format_) : out(out_), format(format_) {}
+
+    void JsonWriter::begin_file(std::string_view path)
+    {
+        written.clear();
+        first_record = true;
+        if (format == OutputFormat::Ndjson)
+        {
+            out << "{\"file\":";
+            write_json_string(out, path);
+            out << "}\n";
+            return;
+        }
+
+        out << (first_file ? "[\n" : ",\n") << "{\"file\":";
+        write_json_string(out, path);
+        out << ",\"nodes\":[\n";
+        first_file = false;
+    }
+
+    void JsonWriter::end_file()
+    {
+        if (format == OutputFormat::Json)
+            out << "\n]}";
+    }
+
+    void JsonWriter::finish()
+    {
+        if (format == OutputFormat::Json)
+            out << (first_file ? "[]\n" : "\n]\n");
+    }
+
+    void JsonWriter::write(const Node& root)
+    {
+        work.push_back(&root);
+        while (not work.empty())
+        {
+            const auto* node = work.back();
+            work.pop_back();
+            if (not written.insert(node).second)
+                continue;
+
+            write_record(*node);
+            // Push in reverse, so that the children are written in order.
+            for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                work.push_back(*it);
+        }
+    }
+
+    void JsonWriter::write_record(const Node& node)
+    {
+        if (format == OutputFormat::Json and not first_record)
+            out << ",\n";
+        first_record = false;
+
+        out << "{\"key\":";
+        write_key(out, node.key);
+        out << ",\"id\":";
+        write_json_string(out, node.id);
+
+        out << ",\"props\":{";
+        const char* sep = "";
+        for (const auto& [name, value] : node.props)
+        {
+            out << sep;
+            write_json_string(out, name);
+            out << ':';
+            write_json_string(out, value);
+            sep = ",";
+        }
+
+        out << "},\"children\":[";
+        sep = "";
+        for (const auto* child : node.children)
+        {
+            out << sep;
+            write_key(out, child->key);
+            sep = ",";
+        }
+
+        out << "],\"refs\":[";
+        sep = "";
+        for (const auto& key : node.references)
+        {
+            out << sep;
+            write_key(out, key);
+            sep = ",";
+        }
+        out << "]}";
+
+        if (format == OutputFormat::Ndjson)
+            out << '\n';
+    }
+} // namespace ifc::util
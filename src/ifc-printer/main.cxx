@@ -1,12 +1,19 @@
 // Copyright Microsoft Corporation.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <charconv>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <condition_variable>
 #include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include "ifc/reader.hxx"
 #include "ifc/dom/node.hxx"
+#include "ifc/dom/snapshot.hxx"
 #include "printer.hxx"
 
 void translate_exception()
@@ -24,6 +31,10 @@ void translate_exception()
         std::cerr << "visit unexpected " << e.category << ": " 
                   << e.sort << '\n';
     }
+    catch (const ifc::util::InvalidSnapshot&)
+    {
+        std::cerr << "invalid dom snapshot\n";
+    }
     catch (const char* message)
     {
         std::cerr << "caught: " << message;
@@ -39,6 +50,19 @@ using namespace std::literals;
 
 struct Arguments {
     PrintOptions options = PrintOptions::None;
+    OutputFormat format  = OutputFormat::Tree;
+
+    // Directory of DOM snapshots, keyed by IFC content hash. Empty if not caching.
+    std::filesystem::path snapshot_dir;
+
+    // Number of files processed at the same time.
+    unsigned jobs = 1;
+
+    // Declarations to print; everything if empty.
+    Query query;
+
+    // Shape of the graph, for the graph formats.
+    GraphOptions graph;
 
     // Files to process.
     std::vector<std::string> files;
@@ -48,10 +72,55 @@ void print_help(std::filesystem::path path)
 {
     auto name = path.stem().string();
     std::cout << "Usage:\n\n";
-    std::cout << name << " ifc-file1 [ifc-file2 ...] [--color/-c]\n";
+    std::cout << name << " ifc-file1 [ifc-file2 ...] [--color/-c] [--format=tree|json|ndjson|dot|graphml] [--snapshot-dir dir] [--jobs N]\n";
+    std::cout << std::string(name.size(), ' ')
+              << " [--decl-sort=sort,...] [--name-regex=re] [--scope=ns::path] [--max-depth=N]\n";
+    std::cout << std::string(name.size(), ' ')
+              << " [--graph-kinds=kind,...] [--node-budget=N] [--cluster-scopes]\n";
     std::cout << name << " --help/-h\n";
 }
 
+[[noreturn]] void usage_error(const char* prog, std::string_view message, std::string_view arg)
+{
+    std::cout << message << " '" << arg << "'\n";
+    print_help(prog);
+    std::exit(1);
+}
+
+// Parse a decimal count, with `lowest` as the smallest value accepted.
+unsigned parse_count(const char* prog, std::string_view arg, unsigned lowest)
+{
+    unsigned count = 0;
+    auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), count);
+    if (error != std::errc{} or end != arg.data() + arg.size() or count < lowest)
+        usage_error(prog, "Invalid count", arg);
+    return count;
+}
+
+// Split the text at each occurrence of the separator.
+std::vector<std::string> split(std::string_view text, std::string_view separator)
+{
+    std::vector<std::string> result;
+    for (auto pos = text.find(separator); pos != text.npos; pos = text.find(separator))
+    {
+        result.emplace_back(text.substr(0, pos));
+        text.remove_prefix(pos + separator.size());
+    }
+    result.emplace_back(text);
+    return result;
+}
+
+std::optional<SortKind> parse_sort_kind(std::string_view name)
+{
+    for (auto kind : {SortKind::Expr, SortKind::Decl, SortKind::Type, SortKind::Name, SortKind::Scope,
+                      SortKind::Sentence, SortKind::Chart, SortKind::Syntax, SortKind::Stmt})
+    {
+        if (to_string(kind) == name)
+            return kind;
+    }
+    return {};
+}
+
 Arguments process_args(int argc, char** argv)
 {
     Arguments result;
@@ -66,6 +135,81 @@ Arguments process_args(int argc, char** argv)
         {
             result.options |= PrintOptions::Use_color;
         }
+        else if (argv[i] == "--format=tree"sv)
+        {
+            result.format = OutputFormat::Tree;
+        }
+        else if (argv[i] == "--format=json"sv)
+        {
+            result.format = OutputFormat::Json;
+        }
+        else if (argv[i] == "--format=ndjson"sv)
+        {
+            result.format = OutputFormat::Ndjson;
+        }
+        else if (argv[i] == "--format=dot"sv)
+        {
+            result.format = OutputFormat::Dot;
+        }
+        else if (argv[i] == "--format=graphml"sv)
+        {
+            result.format = OutputFormat::GraphML;
+        }
+        else if (argv[i] == "--cluster-scopes"sv)
+        {
+            result.graph.cluster_scopes = true;
+        }
+        else if (argv[i] == "--snapshot-dir"sv and i + 1 < argc)
+        {
+            result.snapshot_dir = argv[++i];
+        }
+        else if (argv[i] == "--jobs"sv and i + 1 < argc)
+        {
+            result.jobs = parse_count(argv[0], argv[++i], 1);
+        }
+        else if (std::string_view arg = argv[i]; arg.starts_with("--decl-sort="))
+        {
+            for (const auto& name : split(arg.substr(arg.find('=') + 1), ","))
+            {
+                auto sort = parse_decl_sort(name);
+                if (not sort)
+                    usage_error(argv[0], "Unknown declaration sort", name);
+                result.query.sorts.push_back(*sort);
+            }
+        }
+        else if (arg.starts_with("--name-regex="))
+        {
+            try
+            {
+                result.query.name.emplace(std::string{arg.substr(arg.find('=') + 1)});
+            }
+            catch (const std::regex_error&)
+            {
+                usage_error(argv[0], "Invalid regular expression", arg.substr(arg.find('=') + 1));
+            }
+        }
+        else if (arg.starts_with("--scope="))
+        {
+            result.query.scope = split(arg.substr(arg.find('=') + 1), "::");
+        }
+        else if (arg.starts_with("--max-depth="))
+        {
+            result.query.max_depth = parse_count(argv[0], arg.substr(arg.find('=') + 1), 0);
+        }
+        else if (arg.starts_with("--graph-kinds="))
+        {
+            for (const auto& name : split(arg.substr(arg.find('=') + 1), ","))
+            {
+                auto kind = parse_sort_kind(name);
+                if (not kind)
+                    usage_error(argv[0], "Unknown node kind", name);
+                result.graph.kinds.push_back(*kind);
+            }
+        }
+        else if (arg.starts_with("--node-budget="))
+        {
+            result.graph.node_budget = parse_count(argv[0], arg.substr(arg.find('=') + 1), 1);
+        }
         // Future flags to add as needed
         //   -l --location: print locations
         //   -h --header: print module header
@@ -104,8 +248,42 @@ std::vector<std::byte> load_file(const std::string& name)
     return v;
 }
 
-void process_ifc(const std::string& name, PrintOptions options)
+std::vector<std::byte> load_file(const std::filesystem::path& path)
 {
+    return load_file(path.string());
+}
+
+// Write the file in one step, so a concurrent reader never sees a partial file.
+// The temporary file is private to the thread, as workers may store the same file.
+void store_file(const std::filesystem::path& path, const std::vector<std::byte>& bytes)
+{
+    auto temp = path;
+    temp += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+    std::filesystem::rename(temp, path);
+}
+
+std::unique_ptr<RecordWriter> make_record_writer(OutputBuffer& out, const Arguments& arguments)
+{
+    switch (arguments.format)
+    {
+    case OutputFormat::Json:
+    case OutputFormat::Ndjson:
+        return std::make_unique<JsonWriter>(out, arguments.format);
+    case OutputFormat::Dot:
+    case OutputFormat::GraphML:
+        return std::make_unique<GraphWriter>(out, arguments.format, arguments.graph);
+    default:
+        return nullptr;
+    }
+}
+
+void process_ifc(const std::string& name, const Arguments& arguments, OutputBuffer& out, RecordWriter* records)
+{
+    auto options = arguments.options;
     auto contents = load_file(name);
 
     ifc::InputIfc file{gsl::span(contents)};
@@ -114,21 +292,155 @@ void process_ifc(const std::string& name, PrintOptions options)
                                           ifc::IfcOptions::IntegrityCheck);
 
     ifc::Reader reader(file);
-    ifc::util::Loader loader(reader);
-    auto& gs = loader.get(reader.ifc.header()->global_scope);
-    print(gs, std::cout, options);
+    // Printing loads the whole module; visit the records in file order.
+    ifc::util::Loader loader(reader, ifc::util::LoadOrder::Address);
 
-    // Make sure that we resolve and print all
-    // referenced nodes.
-    options |= PrintOptions::Top_level_index;
-    while (not loader.referenced_nodes.empty())
+    // Reuse the nodes of an earlier run over the same contents; a file with a different
+    // content hash has a different snapshot name, so stale snapshots are never picked up.
+    std::filesystem::path snapshot_path;
+    std::vector<std::byte> snapshot_bytes;
+    std::optional<ifc::util::Snapshot> snapshot;
+    if (not arguments.snapshot_dir.empty())
     {
-        auto it             = loader.referenced_nodes.begin();
-        const auto node_key = *it;
-        loader.referenced_nodes.erase(it);
+        snapshot_path = arguments.snapshot_dir / snapshot_file_name(file.header()->content_hash);
+        if (std::filesystem::exists(snapshot_path))
+        {
+            snapshot_bytes = load_file(snapshot_path);
+            try
+            {
+                snapshot.emplace(snapshot_bytes);
+                loader.attach(*snapshot);
+            }
+            catch (const ifc::util::InvalidSnapshot&)
+            {
+                // Written by another version, or damaged; it is replaced below.
+                snapshot.reset();
+            }
+        }
+    }
 
-        auto& item = loader.get(node_key);
-        print(item, std::cout, options);
+    auto emit = [&](const ifc::util::Node& node) {
+        if (records == nullptr)
+            print(node, out, options);
+        else
+            records->write(node);
+    };
+
+    if (not arguments.query.empty())
+    {
+        // Print the selected declarations only, without what they refer to.
+        options |= PrintOptions::Top_level_index;
+        for (auto decl : select(loader, arguments.query))
+            emit(loader.get(decl));
+    }
+    else
+    {
+        auto& gs = loader.get(reader.ifc.header()->global_scope);
+        emit(gs);
+
+        // Make sure that we resolve and print all
+        // referenced nodes.
+        options |= PrintOptions::Top_level_index;
+        while (not loader.referenced_nodes.empty())
+        {
+            auto it             = loader.referenced_nodes.begin();
+            const auto node_key = *it;
+            loader.referenced_nodes.erase(it);
+
+            auto& item = loader.get(node_key);
+            emit(item);
+        }
+    }
+
+    if (records != nullptr)
+        records->end_records();
+
+    // Only a full run loads every node worth recording.
+    if (not snapshot_path.empty() and not snapshot and arguments.query.empty())
+    {
+        std::filesystem::create_directories(arguments.snapshot_dir);
+        store_file(snapshot_path, write_snapshot(loader));
+    }
+}
+
+// Output of a file rendered by a worker, waiting for its turn to be written.
+struct RenderedFile {
+    std::string text;
+    std::exception_ptr error;
+    bool done = false;
+};
+
+// Render the files on `arguments.jobs` threads, and write them out in argument order.
+// At most two files per thread are rendered ahead of the one being written, which bounds
+// the memory held by the output of files waiting for their turn.
+void process_in_parallel(const Arguments& arguments, OutputBuffer& out, RecordWriter* framing)
+{
+    const auto count  = arguments.files.size();
+    const auto window = 2 * std::size_t{arguments.jobs};
+    std::vector<RenderedFile> rendered(count);
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::size_t next    = 0; // next file to be claimed by a worker
+    std::size_t written = 0; // files written out so far
+    bool stop           = false;
+
+    auto work = [&] {
+        std::unique_lock lock{mutex};
+        for (;;)
+        {
+            changed.wait(lock, [&] { return stop or next == count or next < written + window; });
+            if (stop or next == count)
+                return;
+            const auto i = next++;
+            lock.unlock();
+
+            RenderedFile file;
+            try
+            {
+                OutputBuffer buffer{file.text};
+                auto records = make_record_writer(buffer, arguments);
+                process_ifc(arguments.files[i], arguments, buffer, records.get());
+                buffer.flush();
+            }
+            catch (...)
+            {
+                file.error = std::current_exception();
+            }
+            file.done = true;
+
+            lock.lock();
+            rendered[i] = std::move(file);
+            changed.notify_all();
+        }
+    };
+
+    // Declared last, so the workers are joined before the state they share goes away.
+    std::vector<std::jthread> workers;
+    for (unsigned i = 0; i < std::min<std::size_t>(arguments.jobs, count); ++i)
+        workers.emplace_back(work);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::string text;
+        {
+            std::unique_lock lock{mutex};
+            changed.wait(lock, [&] { return rendered[i].done; });
+            if (rendered[i].error)
+            {
+                stop = true;
+                changed.notify_all();
+                std::rethrow_exception(rendered[i].error);
+            }
+            text = std::move(rendered[i].text);
+            ++written;
+            changed.notify_all();
+        }
+
+        if (framing != nullptr)
+            framing->begin_file(arguments.files[i]);
+        out << text;
+        if (framing != nullptr)
+            framing->end_file();
     }
 }
 
@@ -138,8 +450,27 @@ int main(int argc, char** argv)
 
     try
     {
-        for (const auto& file : arguments.files)
-            process_ifc(file, arguments.options);
+        // Bypass the iostreams: the output goes straight to the standard output descriptor.
+        OutputBuffer out{1};
+        auto records = make_record_writer(out, arguments);
+        if (arguments.jobs > 1 and arguments.files.size() > 1)
+        {
+            process_in_parallel(arguments, out, records.get());
+        }
+        else
+        {
+            for (const auto& file : arguments.files)
+            {
+                if (records != nullptr)
+                    records->begin_file(file);
+                process_ifc(file, arguments, out, records.get());
+                if (records != nullptr)
+                    records->end_file();
+            }
+        }
+        if (records != nullptr)
+            records->finish();
+        out.flush();
     }
     catch (...)
     {
@@ -2,11 +2,18 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "printer.hxx"
-#include <iostream>
-
-#include <stack>
+#include <charconv>
+#include <cstring>
+#include <ostream>
 #include <set>
 
+#ifdef WIN32
+#   include <io.h>
+#else
+#   include <unistd.h>
+#   include <cerrno>
+#endif
+
 namespace ifc::util {
     namespace {
         // Values of enum refer to the escaped console color code '\u001b[<XXX>m'.
@@ -22,19 +29,19 @@ namespace ifc::util {
             White,
         };
 
-        std::ostream& operator<<(std::ostream& os, ConsoleColor color)
+        OutputBuffer& operator<<(OutputBuffer& out, ConsoleColor color)
         {
-            os << "\u001b[" << static_cast<int>(color) << "m";
-            return os;
+            return out << "\u001b[" << static_cast<uint32_t>(color) << 'm';
         }
 
         class ScopedConsoleColor {
         public:
-            ScopedConsoleColor(std::ostream& os_, ConsoleColor color, bool enabled_ = true) : os(os_), enabled(enabled_)
+            ScopedConsoleColor(OutputBuffer& out_, ConsoleColor color, bool enabled_ = true)
+              : out(out_), enabled(enabled_)
             {
                 if (enabled)
                 {
-                    os << color;
+                    out << color;
                 }
             }
 
@@ -42,12 +49,12 @@ namespace ifc::util {
             {
                 if (enabled)
                 {
-                    os << ConsoleColor::None;
+                    out << ConsoleColor::None;
                 }
             }
 
         private:
-            std::ostream& os;
+            OutputBuffer& out;
             bool enabled = true;
         };
 
@@ -118,45 +125,45 @@ namespace ifc::util {
                 // Some known properties are too noisy (such as alignment), we don't print it at all.
                 static std::set<std::string> known = {"name",   "type",      "base",      "source",
                                                       "assort", "pack_size", "alignment", "home-scope"};
-                stream << indent.c_str();
+                out << indent;
                 {
                     ColorSetter color(*this, get_node_color(n.key.kind()));
-                    stream << n.id;
+                    out << n.id;
                     // Only declarations have an index embedded in the id, but, if a
                     // use requested printing of index, we will print it as requested.
                     if (depth == 0 and implies(options, PrintOptions::Top_level_index)
                         and n.key.kind() != SortKind::Decl)
-                        stream << "-" << n.key.index();
+                        out << '-' << n.key.index();
                 }
                 if (auto it = n.props.find("type"); it != n.props.end())
                 {
                     ColorSetter color(*this, get_node_color(SortKind::Type));
-                    stream << " '" << get_string_prop(it->second) << "'";
+                    out << " '" << get_string_prop(it->second) << '\'';
                 }
                 if (auto it = n.props.find("name"); it != n.props.end())
                 {
                     ColorSetter color(*this, get_node_color(SortKind::Name));
-                    stream << " " << get_string_prop(it->second);
+                    out << ' ' << get_string_prop(it->second);
                 }
                 if (auto it = n.props.find("base"); it != n.props.end())
                 {
                     ColorSetter color(*this, get_node_color(SortKind::Type));
-                    stream << " :" << get_string_prop(it->second);
+                    out << " :" << get_string_prop(it->second);
                 }
                 if (auto it = n.props.find("assort"); it != n.props.end())
                 {
                     ColorSetter color(*this, get_node_color(SortKind::Name));
-                    stream << " " << get_string_prop(it->second);
+                    out << ' ' << get_string_prop(it->second);
                 }
                 if (auto it = n.props.find("pack_size"); it != n.props.end())
                 {
                     ColorSetter color(*this, get_node_color(SortKind::Name));
-                    stream << " packed-" << get_string_prop(it->second);
+                    out << " packed-" << get_string_prop(it->second);
                 }
                 if (auto it = n.props.find("home-scope"); it != n.props.end())
                 {
                     ColorSetter color(*this, get_node_color(SortKind::Stmt));
-                    stream << " home-scope(" << get_string_prop(it->second) << ")";
+                    out << " home-scope(" << get_string_prop(it->second) << ')';
                 }
 
                 // dump the rest of the properties in a boring white.
@@ -164,27 +171,42 @@ namespace ifc::util {
 
                 for (auto& entry : n.props)
                     if (not known.contains(entry.first))
-                        if (std::string str = get_string_prop(entry.second); not str.empty())
-                            stream << ' ' << str;
+                        if (const auto& str = get_string_prop(entry.second); not str.empty())
+                            out << ' ' << str;
 
-                stream << std::endl;
+                out << '\n';
             }
 
-            void visit(const Node& n)
+            // Walk the tree with an explicit stack so that deeply nested nodes
+            // (e.g. large initializers) do not exhaust the native stack.
+            void visit(const Node& root)
             {
+                struct Frame {
+                    const Node* node;
+                    size_t next_child;
+                };
+
                 // special case for the topmost node.
-                if (depth == 0)
-                    dump_node_header(n, ChildType::Only_child);
+                dump_node_header(root, ChildType::Only_child);
 
+                std::vector<Frame> frames{{&root, 0}};
                 ++depth;
-                const auto total   = n.children.size();
-                size_t child_count = 0;
-                for (auto* child : n.children)
+                while (not frames.empty())
                 {
-                    dump_node_header(*child, compute_child_type(++child_count, total));
-                    visit(*child);
+                    auto& top        = frames.back();
+                    const auto total = top.node->children.size();
+                    if (top.next_child == total)
+                    {
+                        frames.pop_back();
+                        --depth;
+                        continue;
+                    }
+
+                    auto* child = top.node->children[top.next_child++];
+                    dump_node_header(*child, compute_child_type(top.next_child, total));
+                    frames.push_back({child, 0});
+                    ++depth;
                 }
-                --depth;
             }
 
             TreePrinter& operator<<(std::string_view str);
@@ -192,23 +214,27 @@ namespace ifc::util {
 
             void update_indent(size_t, ChildType);
 
-            explicit TreePrinter(std::ostream& stream_, PrintOptions options_ = {}) : stream(stream_), options(options_) {}
+            explicit TreePrinter(OutputBuffer& out_, PrintOptions options_ = {}) : out(out_), options(options_) {}
 
             struct ColorSetter : ScopedConsoleColor {
                 ColorSetter(TreePrinter& pp, ConsoleColor color)
-                  : ScopedConsoleColor(pp.stream, color, implies(pp.options, PrintOptions::Use_color))
+                  : ScopedConsoleColor(pp.out, color, implies(pp.options, PrintOptions::Use_color))
                 {}
             };
 
         private:
             size_t depth{0};
 
-            std::ostream& stream;
+            OutputBuffer& out;
             PrintOptions options;
 
+            // The indentation is a flat buffer of fixed-width marks, one per level, with
+            // the corresponding actions kept alongside; undoing an action just truncates it.
+            static constexpr size_t indent_width = 2;
             std::string indent;
-            std::stack<IndentAction> indents;
-            std::string indent_strs[static_cast<int>(IndentAction::Recurse_last) + 1]{"|-", "\\-", "| ", "  "};
+            std::vector<IndentAction> indents;
+            static constexpr std::string_view indent_strs[static_cast<int>(IndentAction::Recurse_last) + 1]{
+                "|-", "\\-", "| ", "  "};
         };
 
         TreePrinter& TreePrinter::operator<<(IndentAction action)
@@ -216,14 +242,13 @@ namespace ifc::util {
             using enum_type = std::underlying_type<IndentAction>::type;
             if (action != IndentAction::Undo)
             {
-                indents.push(action);
-                indent += indent_strs[static_cast<enum_type>(action)];
+                indents.push_back(action);
+                indent.append(indent_strs[static_cast<enum_type>(action)]);
             }
             else if (not indents.empty())
             {
-                auto indent_size = indent_strs[static_cast<enum_type>(indents.top())].size();
-                indent           = indent.substr(0, indent.size() - indent_size);
-                indents.pop();
+                indent.resize(indent.size() - indent_width);
+                indents.pop_back();
             }
 
             return *this;
@@ -236,11 +261,11 @@ namespace ifc::util {
 
             if (not indents.empty() and (child_type == ChildType::First or child_type == ChildType::Only_child))
             {
-                if (indents.top() == IndentAction::Child)
+                if (indents.back() == IndentAction::Child)
                 {
                     *this << IndentAction::Undo << IndentAction::Recurse;
                 }
-                else if (indents.top() == IndentAction::Last_child)
+                else if (indents.back() == IndentAction::Last_child)
                 {
                     *this << IndentAction::Undo << IndentAction::Recurse_last;
                 }
@@ -262,10 +287,97 @@ namespace ifc::util {
         }
     } // namespace
 
-    void print(const Node& node, std::ostream& os, PrintOptions options)
+    OutputBuffer::OutputBuffer(int fd_) : buffer(new char[capacity]), fd(fd_) {}
+
+    OutputBuffer::OutputBuffer(std::ostream& stream_) : buffer(new char[capacity]), stream(&stream_) {}
+
+    OutputBuffer::OutputBuffer(std::string& text_) : buffer(new char[capacity]), text(&text_) {}
+
+    OutputBuffer::~OutputBuffer()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+            // Nowhere to report it; the owner calls flush() to find out.
+        }
+    }
+
+    OutputBuffer& OutputBuffer::operator<<(std::string_view str)
+    {
+        if (str.size() > capacity - used)
+        {
+            flush();
+            if (str.size() > capacity)
+            {
+                write_out(str.data(), str.size());
+                return *this;
+            }
+        }
+        std::memcpy(buffer.get() + used, str.data(), str.size());
+        used += str.size();
+        return *this;
+    }
+
+    OutputBuffer& OutputBuffer::operator<<(uint32_t value)
     {
-        TreePrinter tree(os, options);
+        char digits[10];
+        const auto end = std::to_chars(digits, digits + sizeof digits, value).ptr;
+        return *this << std::string_view{digits, end};
+    }
+
+    void OutputBuffer::flush()
+    {
+        const auto size = used;
+        used            = 0;
+        write_out(buffer.get(), size);
+    }
+
+    void OutputBuffer::write_out(const char* data, size_t size)
+    {
+        if (text != nullptr)
+        {
+            text->append(data, size);
+            return;
+        }
+
+        if (stream != nullptr)
+        {
+            stream->write(data, static_cast<std::streamsize>(size));
+            stream->flush();
+            return;
+        }
+
+        while (size != 0)
+        {
+#ifdef WIN32
+            const auto chunk   = static_cast<unsigned>(std::min<size_t>(size, 1u << 30));
+            const auto written = _write(fd, data, chunk);
+#else
+            const auto written = ::write(fd, data, size);
+            if (written < 0 and errno == EINTR)
+                continue;
+#endif
+            if (written <= 0)
+                throw "error writing the output";
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void print(const Node& node, OutputBuffer& out, PrintOptions options)
+    {
+        TreePrinter tree(out, options);
         tree.visit(node);
     }
 
+    void print(const Node& node, std::ostream& os, PrintOptions options)
+    {
+        OutputBuffer out(os);
+        print(node, out, options);
+        out.flush();
+    }
+
 } // namespace ifc::util
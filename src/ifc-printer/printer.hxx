@@ -5,7 +5,15 @@
 #define IFC_TOOLS_PRINTER_HXX
 
 #include "ifc/dom/node.hxx"
-#include <ostream>
+#include <iosfwd>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 
 namespace ifc::util {
     enum class PrintOptions : int8_t {
@@ -22,7 +30,174 @@ namespace ifc::util {
         return e1 = e1 | e2;
     }
 
+    // Printer output is accumulated in a large buffer and handed over in big chunks,
+    // either written straight to a file descriptor or to a stream, or appended to a string.
+    class OutputBuffer {
+    public:
+        static constexpr size_t capacity = size_t{1} << 20;
+
+        explicit OutputBuffer(int fd);
+        explicit OutputBuffer(std::ostream& stream);
+        explicit OutputBuffer(std::string& text);
+        OutputBuffer(const OutputBuffer&)            = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+        ~OutputBuffer();
+
+        OutputBuffer& operator<<(std::string_view str);
+        OutputBuffer& operator<<(uint32_t value);
+
+        OutputBuffer& operator<<(char c)
+        {
+            if (used == capacity)
+                flush();
+            buffer[used++] = c;
+            return *this;
+        }
+
+        // Write out everything buffered so far; throws if the output cannot be written.
+        void flush();
+
+    private:
+        void write_out(const char* data, size_t size);
+
+        std::unique_ptr<char[]> buffer;
+        size_t used          = 0;
+        int fd               = -1;
+        std::ostream* stream = nullptr;
+        std::string* text    = nullptr;
+    };
+
+    void print(const Node& gs, OutputBuffer& out, PrintOptions options = PrintOptions::None);
     void print(const Node& gs, std::ostream& os, PrintOptions options = PrintOptions::None);
+
+    enum class OutputFormat : uint8_t {
+        Tree,    // indented text tree
+        Json,    // a JSON array with one object per file, holding the node records
+        Ndjson,  // one JSON object per line: a {"file"} record, then the node records of that file
+        Dot,     // one Graphviz digraph per file
+        GraphML, // a GraphML document with one graph per file
+    };
+
+    // Writes the nodes of the files as records in a machine-readable format.  The framing of
+    // the document is written by begin_file, end_file and finish, the records of a file by write
+    // and end_records.  The two may go to different buffers, to be put together in file order;
+    // a writer used only for records starts as if begin_file had been called.
+    class RecordWriter {
+    public:
+        virtual ~RecordWriter() = default;
+
+        virtual void begin_file(std::string_view path) = 0;
+        // Write the records of the nodes of the tree, those not yet written for this file.
+        virtual void write(const Node& root) = 0;
+        // Write what is held back until all the trees of the file are written.
+        virtual void end_records() {}
+        virtual void end_file() = 0;
+        // Complete the document after the last file.
+        virtual void finish() = 0;
+    };
+
+    // Write JSON text for the string, with quotes.  Ill-formed UTF-8 is written as U+FFFD.
+    void write_json_string(OutputBuffer& out, std::string_view str);
+
+    // Emits one JSON record per node, of the form
+    //   {"key":"decl.function-3","id":...,"props":{...},"children":[keys...],"refs":[keys...]}
+    // Nodes are written in pre-order as the trees are walked.
+    class JsonWriter final : public RecordWriter {
+    public:
+        JsonWriter(OutputBuffer& out, OutputFormat format);
+
+        void begin_file(std::string_view path) final;
+        void write(const Node& root) final;
+        void end_file() final;
+        void finish() final;
+
+    private:
+        void write_record(const Node& node);
+
+        OutputBuffer& out;
+        OutputFormat format;
+        bool first_file   = true;
+        bool first_record = true;
+        std::unordered_set<const Node*> written;
+        std::vector<const Node*> work;
+    };
+
+    struct GraphOptions {
+        static constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+
+        std::vector<SortKind> kinds;     // kinds of the nodes in the graph; all if empty
+        size_t node_budget  = unlimited; // nodes per file
+        bool cluster_scopes = false;     // group a scope with the nodes first reached from it
+    };
+
+    // Emits the nodes and edges of the DOM as a DOT or GraphML graph.  Child edges are solid,
+    // reference edges dashed.  Nodes and child edges are written as the trees are walked in
+    // pre-order; reference edges are held back until the end of the file, and kept only if
+    // both ends made it into the graph.  Each edge is written once; a node reached from several
+    // parents is written once, with a child edge from each.
+    //
+    // A node of a kind left out of the graph is skipped, but not its subtree: the children
+    // are attached to the nearest ancestor in the graph instead.
+    class GraphWriter final : public RecordWriter {
+    public:
+        GraphWriter(OutputBuffer& out, OutputFormat format, const GraphOptions& options);
+
+        void begin_file(std::string_view path) final;
+        void write(const Node& root) final;
+        void end_records() final;
+        void end_file() final;
+        void finish() final;
+
+    private:
+        // A node to write, with its nearest ancestor in the graph; no node marks the end of a cluster.
+        struct Step {
+            const Node* node;
+            const Node* parent;
+        };
+
+        // Edges are keyed by their packed ends, with the top bit set for references.
+        struct EdgeHash {
+            size_t operator()(const std::pair<uint64_t, uint64_t>& edge) const
+            {
+                return std::hash<uint64_t>{}(edge.first * 0x9E3779B97F4A7C15 ^ edge.second);
+            }
+        };
+
+        bool included(const Node& node) const;
+        void write_node(const Node& node, bool cluster);
+        void write_edge(NodeKey from, NodeKey to, bool reference);
+        void write_label(const Node& node);
+        void close_cluster();
+
+        OutputBuffer& out;
+        OutputFormat format;
+        const GraphOptions& options;
+        bool first_file = true;
+        std::unordered_set<const Node*> visited;
+        std::unordered_set<uint64_t> written; // packed keys of the nodes in the graph
+        std::unordered_set<std::pair<uint64_t, uint64_t>, EdgeHash> edges;
+        std::vector<std::pair<NodeKey, NodeKey>> references;
+        std::vector<Step> work;
+    };
+
+    // Selection of the declarations to print.  It is evaluated on the scopes of the IFC,
+    // before any node is loaded, so that only the selected subtrees are ever decoded.
+    struct Query {
+        static constexpr unsigned unlimited_depth = std::numeric_limits<unsigned>::max();
+
+        std::vector<DeclSort> sorts;          // sorts of the declarations; any if empty
+        std::optional<std::regex> name;       // to be found in the declaration name
+        std::vector<std::string> scope;       // path from the global scope to the scope searched
+        unsigned max_depth = unlimited_depth; // depth of the nested scopes searched; 0 for members only
+
+        bool empty() const;
+    };
+
+    // Sort with the given name, without the partition prefix, e.g. "function" for DeclSort::Function.
+    std::optional<DeclSort> parse_decl_sort(std::string_view name);
+
+    // The matching declarations, in scope order.  Members of a match are not searched.
+    std::vector<DeclIndex> select(Loader& ctx, const Query& query);
 } // namespace ifc::util
 
 #endif // IFC_TOOLS_PRINTER_HXX
\ No newline at end of file
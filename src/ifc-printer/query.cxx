@@ -0,0 +1,108 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "printer.hxx"
+#include "ifc/reader.hxx"
+
+namespace ifc::util {
+    namespace {
+        // Name of the declaration, e.g. "vector"; empty for declarations that have none.
+        std::string decl_name(Loader& ctx, DeclIndex index)
+        {
+            return ctx.reader.visit_with_index(index, [&ctx](DeclIndex, const auto& decl) {
+                if constexpr (requires { decl.identity; })
+                    return ctx.ref(decl.identity);
+                else
+                    return std::string{};
+            });
+        }
+
+        class Search {
+        public:
+            Search(Loader& ctx_, const Query& query_) : ctx(ctx_), query(query_) {}
+
+            // The scope named by the query's scope path, starting from the global scope.
+            ScopeIndex start_scope()
+            {
+                auto scope = ctx.reader.ifc.header()->global_scope;
+                for (const auto& component : query.scope)
+                {
+                    scope = find_scope(scope, component);
+                    if (index_like::null(scope))
+                        throw "scope not found";
+                }
+                return scope;
+            }
+
+            // Walk the members of the scope, collecting the matching declarations.
+            // A match is not searched further: its members are printed along with it.
+            void walk(ScopeIndex index, unsigned depth)
+            {
+                const auto* scope = ctx.reader.try_get(index);
+                if (scope == nullptr)
+                    return;
+
+                for (const auto& member : ctx.reader.sequence(*scope))
+                {
+                    if (matches(member.index))
+                        result.push_back(member.index);
+                    else if (member.index.sort() == DeclSort::Scope and depth < query.max_depth)
+                        walk(ctx.reader.get<symbolic::ScopeDecl>(member.index).initializer, depth + 1);
+                }
+            }
+
+            std::vector<DeclIndex> result;
+
+        private:
+            ScopeIndex find_scope(ScopeIndex index, std::string_view name)
+            {
+                if (const auto* scope = ctx.reader.try_get(index))
+                {
+                    for (const auto& member : ctx.reader.sequence(*scope))
+                    {
+                        if (member.index.sort() == DeclSort::Scope and decl_name(ctx, member.index) == name)
+                            return ctx.reader.get<symbolic::ScopeDecl>(member.index).initializer;
+                    }
+                }
+                return {};
+            }
+
+            bool matches(DeclIndex index)
+            {
+                if (not query.sorts.empty()
+                    and std::find(query.sorts.begin(), query.sorts.end(), index.sort()) == query.sorts.end())
+                    return false;
+                if (query.name)
+                    return std::regex_search(decl_name(ctx, index), *query.name);
+                return true;
+            }
+
+            Loader& ctx;
+            const Query& query;
+        };
+    } // namespace
+
+    bool Query::empty() const
+    {
+        return sorts.empty() and not name and scope.empty() and max_depth == unlimited_depth;
+    }
+
+    std::optional<DeclSort> parse_decl_sort(std::string_view name)
+    {
+        constexpr std::string_view prefix = "decl.";
+        for (auto i = 0u; i < ifc::to_underlying(DeclSort::Count); ++i)
+        {
+            const auto sort = DeclSort(i);
+            if (std::string_view{sort_name(sort)}.substr(prefix.size()) == name)
+                return sort;
+        }
+        return {};
+    }
+
+    std::vector<DeclIndex> select(Loader& ctx, const Query& query)
+    {
+        Search search{ctx, query};
+        search.walk(search.start_scope(), 0);
+        return std::move(search.result);
+    }
+} // namespace ifc::util
@@ -7,14 +7,163 @@ namespace ifc::util {
     using ifc::implies;
 
     namespace {
-        void append(std::string& result, std::string_view suffix, std::string sep = " ")
+        template<typename E>
+        struct FlagWord {
+            E flag;
+            std::string_view word;
+        };
+
+        // Write the words for the flags set in `value`, separated by a single space.
+        template<typename E, std::size_t N>
+        char* format_flags(char* buf, E value, const FlagWord<E> (&words)[N])
         {
-            if (not result.empty() and not suffix.empty())
-                result.append(sep);
-            result.append(suffix);
+            char* const start = buf;
+            for (auto& entry : words)
+            {
+                if (not implies(value, entry.flag))
+                    continue;
+                if (buf != start)
+                    *buf++ = ' ';
+                buf = detail::append(buf, entry.word);
+            }
+            return buf;
+        }
+
+        // Same as above, but the words are wrapped in `prefix(...)` if any flag is set.
+        template<typename E, std::size_t N>
+        char* format_flags(char* buf, E value, std::string_view prefix, const FlagWord<E> (&words)[N])
+        {
+            char* const start = detail::append(buf, prefix);
+            char* const end   = format_flags(start, value, words);
+            if (end == start)
+                return buf;
+            *end = ')';
+            return end + 1;
         }
+
+        // Longest output of format_flags(), used to check the tables against format_buffer_size.
+        template<typename E, std::size_t N>
+        constexpr std::size_t max_length(const FlagWord<E> (&words)[N], std::string_view prefix = {})
+        {
+            std::size_t length = prefix.size() + N;
+            for (auto& entry : words)
+                length += entry.word.size();
+            return length;
+        }
+
+        // clang-format off
+        constexpr FlagWord<BasicSpecifiers> basic_specifier_words[] = {
+            { BasicSpecifiers::C,                      "c-linkage" },
+            { BasicSpecifiers::Internal,               "internal" },
+            { BasicSpecifiers::Vague,                  "vague" },
+            { BasicSpecifiers::External,               "external" },
+            { BasicSpecifiers::Deprecated,             "deprecated" },
+            { BasicSpecifiers::InitializedInClass,     "initialized-in-class" },
+            { BasicSpecifiers::IsMemberOfGlobalModule, "member-of-global-module" },
+        };
+
+        constexpr FlagWord<ScopeTraits> scope_trait_words[] = {
+            { ScopeTraits::Unnamed,             "unnamed" },
+            { ScopeTraits::Inline,              "inline" },
+            { ScopeTraits::InitializerExported, "initializer-exported" },
+            { ScopeTraits::ClosureType,         "closure-type" },
+            { ScopeTraits::Vendor,              "vendor" },
+        };
+
+        constexpr FlagWord<ReachableProperties> reachable_property_words[] = {
+            { ReachableProperties::Initializer,      "initializer" },
+            { ReachableProperties::DefaultArguments, "default-args" },
+            { ReachableProperties::Attributes,       "attributes" },
+        };
+
+        constexpr FlagWord<ObjectTraits> object_trait_words[] = {
+            { ObjectTraits::Constexpr,           "constexpr" },
+            { ObjectTraits::Mutable,             "mutable" },
+            { ObjectTraits::ThreadLocal,         "thread_local" },
+            { ObjectTraits::InitializerExported, "object-initializer-exported" },
+            { ObjectTraits::NoUniqueAddress,     "no-unique-address" },
+            { ObjectTraits::Vendor,              "object-vendor-traits" },
+        };
+
+        constexpr FlagWord<FunctionTraits> function_trait_words[] = {
+            { FunctionTraits::Inline,       "inline" },
+            { FunctionTraits::Constexpr,    "constexpr" },
+            { FunctionTraits::Explicit,     "explicit" },
+            { FunctionTraits::Virtual,      "virtual" },
+            { FunctionTraits::NoReturn,     "no-return" },
+            { FunctionTraits::PureVirtual,  "pure-virtual" },
+            { FunctionTraits::HiddenFriend, "hidden-friend" },
+            { FunctionTraits::Defaulted,    "defaulted" },
+            { FunctionTraits::Deleted,      "deleted" },
+            { FunctionTraits::Constrained,  "constrained" },
+            { FunctionTraits::Immediate,    "immediate" },
+            { FunctionTraits::Final,        "final" },
+            { FunctionTraits::Override,     "override" },
+            { FunctionTraits::Vendor,       "function-vendor-traits" },
+        };
+
+        constexpr FlagWord<Qualifier> qualifier_words[] = {
+            { Qualifier::Const,    "const" },
+            { Qualifier::Volatile, "volatile" },
+            { Qualifier::Restrict, "restrict" },
+        };
+
+        constexpr FlagWord<GuideTraits> guide_trait_words[] = {
+            { GuideTraits::Explicit, "explicit" },
+        };
+
+        constexpr FlagWord<symbolic::BaseClassTraits> base_class_trait_words[] = {
+            { symbolic::BaseClassTraits::Shared,   "Shared" },
+            { symbolic::BaseClassTraits::Expanded, "Expanded" },
+        };
+        // clang-format on
+
+        static_assert(max_length(function_trait_words) <= format_buffer_size);
+        static_assert(max_length(object_trait_words) <= format_buffer_size);
+        static_assert(max_length(basic_specifier_words) <= format_buffer_size);
+        static_assert(max_length(scope_trait_words, "scope-traits(") <= format_buffer_size);
     } // namespace
 
+    char* format_to(char* buf, BasicSpecifiers basic)
+    {
+        return format_flags(buf, basic, basic_specifier_words);
+    }
+
+    char* format_to(char* buf, ScopeTraits traits)
+    {
+        return format_flags(buf, traits, "scope-traits(", scope_trait_words);
+    }
+
+    char* format_to(char* buf, ReachableProperties reachable)
+    {
+        return format_flags(buf, reachable, "reachable(", reachable_property_words);
+    }
+
+    char* format_to(char* buf, ObjectTraits traits)
+    {
+        return format_flags(buf, traits, object_trait_words);
+    }
+
+    char* format_to(char* buf, FunctionTraits traits)
+    {
+        return format_flags(buf, traits, function_trait_words);
+    }
+
+    char* format_to(char* buf, Qualifier qual)
+    {
+        return format_flags(buf, qual, qualifier_words);
+    }
+
+    char* format_to(char* buf, GuideTraits traits)
+    {
+        return format_flags(buf, traits, guide_trait_words);
+    }
+
+    char* format_to(char* buf, symbolic::BaseClassTraits traits)
+    {
+        return format_flags(buf, traits, base_class_trait_words);
+    }
+
     std::string to_string(Access access)
     {
         switch (access)
@@ -34,127 +183,38 @@ namespace ifc::util {
 
     std::string to_string(BasicSpecifiers basic)
     {
-        std::string result;
-        if (implies(basic, BasicSpecifiers::C))
-            append(result, "c-linkage");
-        if (implies(basic, BasicSpecifiers::Internal))
-            append(result, "internal");
-        if (implies(basic, BasicSpecifiers::Vague))
-            append(result, "vague");
-        if (implies(basic, BasicSpecifiers::External))
-            append(result, "external");
-        if (implies(basic, BasicSpecifiers::Deprecated))
-            append(result, "deprecated");
-        if (implies(basic, BasicSpecifiers::InitializedInClass))
-            append(result, "initialized-in-class");
-        if (implies(basic, BasicSpecifiers::IsMemberOfGlobalModule))
-            append(result, "member-of-global-module");
-
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, basic)};
     }
 
     std::string to_string(ScopeTraits traits)
     {
-        std::string result;
-        if (implies(traits, ScopeTraits::Unnamed))
-            append(result, "unnamed");
-        if (implies(traits, ScopeTraits::Inline))
-            append(result, "inline");
-        if (implies(traits, ScopeTraits::InitializerExported))
-            append(result, "initializer-exported");
-        if (implies(traits, ScopeTraits::ClosureType))
-            append(result, "closure-type");
-        if (implies(traits, ScopeTraits::Vendor))
-            append(result, "vendor");
-
-        if (result.empty())
-            return result;
-
-        result.insert(0, "scope-traits(");
-        result.push_back(')');
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, traits)};
     }
 
     std::string to_string(ReachableProperties reachable)
     {
-        std::string result;
-        if (implies(reachable, ReachableProperties::Initializer))
-            append(result, "initializer");
-        if (implies(reachable, ReachableProperties::DefaultArguments))
-            append(result, "default-args");
-        if (implies(reachable, ReachableProperties::Attributes))
-            append(result, "attributes");
-
-        if (result.empty())
-            return result;
-
-        result.insert(0, "reachable(");
-        result.push_back(')');
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, reachable)};
     }
 
     std::string to_string(ObjectTraits traits)
     {
-        std::string result;
-        if (implies(traits, ObjectTraits::Constexpr))
-            append(result, "constexpr");
-        if (implies(traits, ObjectTraits::Mutable))
-            append(result, "mutable");
-        if (implies(traits, ObjectTraits::ThreadLocal))
-            append(result, "thread_local");
-        if (implies(traits, ObjectTraits::InitializerExported))
-            append(result, "object-initializer-exported");
-        if (implies(traits, ObjectTraits::NoUniqueAddress))
-            append(result, "no-unique-address");
-        if (implies(traits, ObjectTraits::Vendor))
-            append(result, "object-vendor-traits");
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, traits)};
     }
 
     std::string to_string(FunctionTraits traits)
     {
-        std::string result;
-        if (implies(traits, FunctionTraits::Inline))
-            append(result, "inline");
-        if (implies(traits, FunctionTraits::Constexpr))
-            append(result, "constexpr");
-        if (implies(traits, FunctionTraits::Explicit))
-            append(result, "explicit");
-        if (implies(traits, FunctionTraits::Virtual))
-            append(result, "virtual");
-        if (implies(traits, FunctionTraits::NoReturn))
-            append(result, "no-return");
-        if (implies(traits, FunctionTraits::PureVirtual))
-            append(result, "pure-virtual");
-        if (implies(traits, FunctionTraits::HiddenFriend))
-            append(result, "hidden-friend");
-        if (implies(traits, FunctionTraits::Defaulted))
-            append(result, "defaulted");
-        if (implies(traits, FunctionTraits::Deleted))
-            append(result, "deleted");
-        if (implies(traits, FunctionTraits::Constrained))
-            append(result, "constrained");
-        if (implies(traits, FunctionTraits::Immediate))
-            append(result, "immediate");
-        if (implies(traits, FunctionTraits::Final))
-            append(result, "final");
-        if (implies(traits, FunctionTraits::Override))
-            append(result, "override");
-        if (implies(traits, FunctionTraits::Vendor))
-            append(result, "function-vendor-traits");
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, traits)};
     }
 
     std::string to_string(ifc::Qualifier qual)
     {
-        std::string result;
-        if (implies(qual, Qualifier::Const))
-            append(result, "const");
-        if (implies(qual, Qualifier::Volatile))
-            append(result, "volatile");
-        if (implies(qual, Qualifier::Restrict))
-            append(result, "restrict");
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, qual)};
     }
 
     std::string to_string(ifc::symbolic::ExpansionMode mode)
@@ -294,21 +354,14 @@ namespace ifc::util {
 
     std::string to_string(GuideTraits traits)
     {
-        std::string result;
-        if (implies(traits, GuideTraits::Explicit))
-            append(result, "explicit");
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, traits)};
     }
 
     std::string to_string(symbolic::BaseClassTraits traits)
     {
-        using Traits = symbolic::BaseClassTraits;
-        std::string result;
-        if (implies(traits, Traits::Shared))
-            append(result, "Shared");
-        if (implies(traits, Traits::Expanded))
-            append(result, "Expanded");
-        return result;
+        char buf[format_buffer_size];
+        return {buf, format_to(buf, traits)};
     }
 
     std::string to_string(symbolic::SourceLocation locus)
@@ -7,22 +7,41 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <optional>
+#include <map>
+#include <memory>
+#include <charconv>
+#include <sstream>
 
 #ifdef WIN32
 #   include <windows.h>
+#else
+#   include <dlfcn.h>
 #endif
 
 #include "ifc/file.hxx"
+#include "ifc/reader.hxx"
 #include "ifc/tooling.hxx"
+#include "ifc/util.hxx"
+#include "ifc/dom/columnar.hxx"
+#include "ifc/dom/grep.hxx"
+#include "ifc/dom/interface.hxx"
+#include "ifc/dom/layout.hxx"
+#include "ifc/dom/modules.hxx"
+#include "ifc/dom/resolver.hxx"
+#include "ifc/dom/stats.hxx"
+#include "ifc/dom/symbols.hxx"
 
 #ifdef WIN32
 #   define STR(S) L ## S
 #   define IFC_MAIN wmain
+#   define IFC_IN std::wcin
 #   define IFC_OUT std::wcout
 #   define IFC_ERR std::wcerr
 #else 
 #   define STR(S) S
 #   define IFC_MAIN main
+#   define IFC_IN std::cin
 #   define IFC_OUT std::cout
 #   define IFC_ERR std::cerr
 #endif
@@ -36,12 +55,19 @@ namespace {
         return s.starts_with(STR("-"));
     }
 
+    // -- The UTF-8 text in the character type of IFC_OUT, through which all the output goes.
+    ifc::tool::String native_text(std::string_view text)
+    {
+        return ifc::fs::path{std::u8string_view{reinterpret_cast<const char8_t*>(text.data()), text.size()}}.native();
+    }
+
     // -- Print a brief message of how to invoke the ifc tool.
     void print_usage(const ifc::fs::path& prog)
     {
         auto name = prog.stem();
         IFC_ERR << name << STR(" usage:\n\t")
-            << name.native() << STR(" <cmd> [options] <ifc-files>\n");
+            << name.native() << STR(" <cmd> [options] <ifc-files>\n\t")
+            << name.native() << STR(" --batch\t\t(commands read from the standard input, one per line)\n");
     }
 
     // -- Check that the input file has a valid IFC file header signature.
@@ -54,9 +80,760 @@ namespace {
         return std::memcmp(sig.data(), std::begin(ifc::InterfaceSignature), sz) == 0;
     }
 
+    // -- An IFC file loaded in memory, with its integrity checked.
+    class LoadedIfc {
+    public:
+        explicit LoadedIfc(const ifc::fs::path& path)
+        {
+            std::ifstream stream{path, std::ios_base::binary};
+            if (not stream)
+                throw "couldn't open file";
+            contents.resize(ifc::fs::file_size(path));
+            if (not stream.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size())))
+                throw "couldn't read file";
+
+            // Any unit is accepted: a mismatch with the (empty) expected designator is not an error,
+            // only a missing header is.
+            file = ifc::InputIfc{gsl::span(contents)};
+            file.validate<ifc::UnitSort::Primary>(ifc::Pathname{path.u8string()}, ifc::Architecture::Unknown,
+                                                  ifc::Pathname{}, ifc::IfcOptions::IntegrityCheck);
+            if (file.header() == nullptr)
+                throw "not a valid IFC file";
+        }
+
+        // The reader refers to the InputIfc, which therefore does not move.
+        LoadedIfc(const LoadedIfc&) = delete;
+        LoadedIfc& operator=(const LoadedIfc&) = delete;
+
+        const ifc::InputIfc& input() const { return file; }
+
+    private:
+        std::vector<std::byte> contents;
+        ifc::InputIfc file;
+    };
+
+    // -- Report the exception being handled, for the file named by `arg`.
+    void report_exception(const ifc::tool::StringView& arg)
+    {
+        IFC_ERR << arg << STR(": ");
+        try
+        {
+            throw;
+        }
+        catch (const ifc::IfcArchMismatch&)
+        {
+            IFC_ERR << STR("ifc architecture mismatch");
+        }
+        catch (const ifc::IntegrityCheckFailed&)
+        {
+            IFC_ERR << STR("integrity check failed");
+        }
+        catch (const ifc::IfcReadFailure& e)
+        {
+            IFC_ERR << STR("couldn't read ") << ifc::fs::path{e.path.c_str()}.native();
+        }
+        catch (const ifc::util::ModuleCycle& e)
+        {
+            IFC_ERR << STR("modules import one another:");
+            for (const auto& name : e.names)
+                IFC_ERR << STR(" ") << ifc::fs::path{name}.native();
+        }
+        catch (const ifc::error_condition::UnexpectedVisitor& e)
+        {
+            IFC_ERR << STR("visit unexpected ") << e.category << STR(": ") << e.sort;
+        }
+        catch (const char* message)
+        {
+            IFC_ERR << message;
+        }
+        catch (const std::exception& e)
+        {
+            IFC_ERR << e.what();
+        }
+        catch (...)
+        {
+            IFC_ERR << STR("unknown exception caught");
+        }
+        IFC_ERR << std::endl;
+    }
+
+    // -- Parse a positive decimal count.
+    std::optional<unsigned> parse_count(const ifc::tool::StringView& s)
+    {
+        if (s.empty() or s.size() > 6)
+            return { };
+        unsigned n = 0;
+        for (auto c : s)
+        {
+            if (c < STR('0') or c > STR('9'))
+                return { };
+            n = n * 10 + static_cast<unsigned>(c - STR('0'));
+        }
+        if (n == 0)
+            return { };
+        return n;
+    }
+
+    // -- Write the output for the IFC file at `path` to <dir>/<stem><extension>, in one step:
+    //    a failure leaves no partial file behind.
+    template<typename F>
+    void store_output(const ifc::fs::path& dir, const ifc::fs::path& path, const ifc::tool::NativeChar* extension, F write)
+    {
+        auto target = dir / path.filename();
+        target.replace_extension(extension);
+        auto temp = target;
+        temp += STR(".tmp");
+        {
+            std::ofstream out{temp, std::ios_base::binary};
+            write(out);
+            if (not out.flush())
+                throw "error writing the output";
+        }
+        ifc::fs::rename(temp, target);
+    }
+
+    // -- Subcommand comparing the interfaces of two builds of a module, see "ifc/dom/interface.hxx".
+    //    Like diff(1), the exit status is 0 if they are the same, 1 if they differ and 2 on error.
+    struct DiffCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("diff"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            bool all = false;
+            unsigned jobs = 0;
+            std::vector<ifc::tool::StringView> files;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("--all"))
+                {
+                    all = true;
+                }
+                else if (arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 2;
+                    }
+                    jobs = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    return 2;
+                }
+                else
+                {
+                    files.push_back(arg);
+                }
+            }
+            if (files.size() != 2)
+            {
+                IFC_ERR << STR("ifc subcommand ") << name() << STR(" compares two IFC files") << std::endl;
+                return 2;
+            }
+
+            std::vector<ifc::util::EntityChange> changes;
+            {
+                std::optional<LoadedIfc> before;
+                std::optional<LoadedIfc> after;
+                for (std::size_t i = 0; i < 2; ++i)
+                {
+                    try
+                    {
+                        (i == 0 ? before : after).emplace(ifc::fs::path{files[i]});
+                    }
+                    catch (...)
+                    {
+                        report_exception(files[i]);
+                        return 2;
+                    }
+                }
+                try
+                {
+                    changes = ifc::util::diff_interfaces(before->input(), after->input(), all, jobs);
+                }
+                catch (...)
+                {
+                    report_exception(files[1]);
+                    return 2;
+                }
+            }
+
+            for (const auto& change : changes)
+            {
+                constexpr const ifc::tool::NativeChar* marks[] = {STR("+ "), STR("- "), STR("~ ")};
+                IFC_OUT << marks[std::to_underlying(change.change)] << native_text(change.kind) << STR(' ')
+                        << native_text(change.name) << STR('\n');
+            }
+            IFC_OUT.flush();
+            return changes.empty() ? 0 : 1;
+        }
+    };
+
+    // -- Subcommand writing the columnar export of IFC files, see "ifc/dom/columnar.hxx".
+    //    Each <file>.ifc becomes <dir>/<file>.ifccol.
+    struct ExportCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("export"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            ifc::fs::path output_dir = STR(".");
+            unsigned jobs = 0;
+            std::vector<ifc::tool::StringView> files;
+            int error_count = 0;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("-o") and i + 1 < args.size())
+                {
+                    output_dir = args[++i];
+                }
+                else if (arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 1;
+                    }
+                    jobs = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    ++error_count;
+                }
+                else
+                {
+                    files.push_back(arg);
+                }
+            }
+
+            for (auto& arg : files)
+            {
+                try
+                {
+                    ifc::fs::path path{arg};
+                    LoadedIfc ifc{path};
+                    ifc::Reader reader{ifc.input()};
+
+                    store_output(output_dir, path, STR(".ifccol"), [&](std::ostream& out) {
+                        ifc::util::write_columnar(reader, out, jobs);
+                    });
+                }
+                catch (...)
+                {
+                    report_exception(arg);
+                    ++error_count;
+                }
+            }
+            return error_count;
+        }
+    };
+
+    // -- Subcommand searching IFC files for declarations by name, see "ifc/dom/grep.hxx".
+    //    Directories are searched for .ifc files, recursively.  With --cache FILE, the identifier
+    //    filters of the files are kept in FILE from one search to the next.  As grep, the exit
+    //    status is 0 if a declaration was found, 1 if none was, and 2 on error.
+    struct GrepCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("grep"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            unsigned jobs = 0;
+            bool regular = false;
+            std::optional<ifc::tool::StringView> pattern;
+            std::optional<ifc::fs::path> cache_file;
+            std::vector<ifc::fs::path> files;
+            bool failed = false;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("--regex"))
+                {
+                    regular = true;
+                }
+                else if (arg == STR("--cache") and i + 1 < args.size())
+                {
+                    cache_file = ifc::fs::path{args[++i]};
+                }
+                else if (arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 2;
+                    }
+                    jobs = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    return 2;
+                }
+                else if (not pattern)
+                {
+                    pattern = arg;
+                }
+                else if (std::error_code error; ifc::fs::is_directory(arg, error))
+                {
+                    const auto first = files.size();
+                    ifc::fs::recursive_directory_iterator it{arg, ifc::fs::directory_options::skip_permission_denied, error};
+                    for (; not error and it != ifc::fs::recursive_directory_iterator{}; it.increment(error))
+                    {
+                        if (it->path().extension() == STR(".ifc") and it->is_regular_file(error))
+                            files.push_back(it->path());
+                    }
+                    std::sort(files.begin() + static_cast<std::ptrdiff_t>(first), files.end());
+                }
+                else
+                {
+                    files.emplace_back(arg);
+                }
+            }
+            if (not pattern)
+            {
+                IFC_ERR << STR("missing pattern to ifc subcommand ") << name() << std::endl;
+                return 2;
+            }
+
+            try
+            {
+                const ifc::util::SymbolPattern symbols{ifc::fs::path{*pattern}.string(), regular};
+                std::optional<ifc::util::FilterCache> cache;
+                if (cache_file)
+                    cache.emplace(*cache_file);
+                const auto results = ifc::util::grep_ifcs(files, symbols, jobs, cache ? &*cache : nullptr);
+                if (cache)
+                    cache->save();
+                bool found = false;
+                // One line per declaration: file, module, name, sort and location; the names are narrow text.
+                for (const auto& file : results)
+                {
+                    if (file.failed)
+                    {
+                        IFC_ERR << file.path.native() << STR(": couldn't read") << std::endl;
+                        failed = true;
+                    }
+                    for (const auto& match : file.matches)
+                        IFC_OUT << file.path.native() << STR('\t') << native_text(ifc::util::to_string(file.module))
+                                << STR('\t') << native_text(match.name) << STR('\t') << native_text(match.kind)
+                                << STR('\t') << native_text(match.location) << STR('\n');
+                    found = found or not file.matches.empty();
+                }
+                IFC_OUT << std::flush;
+                if (failed)
+                    return 2;
+                return found ? 0 : 1;
+            }
+            catch (...)
+            {
+                report_exception(*pattern);
+                return 2;
+            }
+        }
+    };
+
+    // -- Hexadecimal digits of the hash, as written by sha256sum.
+    std::string to_hex(const ifc::SHA256Hash& hash)
+    {
+        std::string result;
+        for (auto word : hash.value)
+        {
+            // The words are stored in host order; print their bytes in file order.
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(&word);
+            for (std::size_t i = 0; i < sizeof word; ++i)
+            {
+                constexpr char digits[] = "0123456789abcdef";
+                result.push_back(digits[bytes[i] >> 4]);
+                result.push_back(digits[bytes[i] & 0xF]);
+            }
+        }
+        return result;
+    }
+
+    // -- Subcommand printing the hash of IFC files: by default, the content hash from the header;
+    //    with --semantic, the hash of their interface, see "ifc/dom/interface.hxx".
+    //    With --entities, the structural hash of each exported entity follows.
+    struct HashCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("hash"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            bool semantic = false;
+            bool entities = false;
+            unsigned jobs = 0;
+            std::vector<ifc::tool::StringView> files;
+            int error_count = 0;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("--semantic"))
+                {
+                    semantic = true;
+                }
+                else if (arg == STR("--entities"))
+                {
+                    semantic = true;
+                    entities = true;
+                }
+                else if (arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 1;
+                    }
+                    jobs = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    ++error_count;
+                }
+                else
+                {
+                    files.push_back(arg);
+                }
+            }
+
+            for (auto& arg : files)
+            {
+                try
+                {
+                    LoadedIfc ifc{ifc::fs::path{arg}};
+                    if (not semantic)
+                    {
+                        IFC_OUT << native_text(to_hex(ifc.input().header()->content_hash)) << STR("  ") << arg
+                                << std::endl;
+                        continue;
+                    }
+
+                    const auto found = ifc::util::interface_entities(ifc.input(), false, jobs);
+                    IFC_OUT << native_text(to_hex(ifc::util::semantic_hash(ifc.input(), found))) << STR("  ") << arg
+                            << std::endl;
+                    if (entities)
+                    {
+                        for (const auto& entity : found)
+                        {
+                            char buf[16];
+                            auto end = std::to_chars(buf, buf + sizeof buf, entity.hash, 16).ptr;
+                            const auto hash = std::string(sizeof buf - (end - buf), '0') + std::string{buf, end};
+                            IFC_OUT << STR("  ") << native_text(hash) << STR(' ') << native_text(entity.kind) << STR(' ')
+                                    << native_text(entity.name) << STR('\n');
+                        }
+                        IFC_OUT.flush();
+                    }
+                }
+                catch (...)
+                {
+                    report_exception(arg);
+                    ++error_count;
+                }
+            }
+            return error_count;
+        }
+    };
+
+    // -- Subcommand building and querying a symbol index of IFC files, see "ifc/dom/symbols.hxx":
+    //        ifc index build [--index FILE] [--jobs N] <dir>...
+    //        ifc index query [--index FILE] <name>...
+    //    A query prints one line per declaration of that name: file, module, qualified name and
+    //    declaration; its exit status is 0 if each name was found, and 1 otherwise.
+    struct IndexCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("index"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            if (args.empty() or (args[0] != STR("build") and args[0] != STR("query")))
+            {
+                IFC_ERR << STR("missing build or query to ifc subcommand ") << name() << std::endl;
+                return 2;
+            }
+            const bool build = args[0] == STR("build");
+            ifc::fs::path index_file = STR("ifc.symbols");
+            unsigned jobs = 0;
+            std::vector<ifc::tool::StringView> operands;
+            for (std::size_t i = 1; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("--index") and i + 1 < args.size())
+                {
+                    index_file = args[++i];
+                }
+                else if (build and arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 2;
+                    }
+                    jobs = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    return 2;
+                }
+                else
+                {
+                    operands.push_back(arg);
+                }
+            }
+
+            try
+            {
+                if (build)
+                {
+                    const std::vector<ifc::fs::path> directories{operands.begin(), operands.end()};
+                    const auto update = ifc::util::build_symbol_index(directories, index_file, jobs);
+                    for (const auto& path : update.failed)
+                        IFC_ERR << path.native() << STR(": couldn't read") << std::endl;
+                    IFC_OUT << update.scanned << STR(" files, ") << update.read << STR(" read, ") << update.removed
+                            << STR(" removed") << std::endl;
+                    return update.failed.empty() ? 0 : 2;
+                }
+
+                const ifc::util::SymbolIndex index{index_file};
+                int missing = 0;
+                for (const auto& arg : operands)
+                {
+                    const auto postings = index.find(ifc::fs::path{arg}.string());
+                    for (const auto& posting : postings)
+                    {
+                        char buf[ifc::util::format_buffer_size];
+                        IFC_OUT << native_text(posting.path) << STR('\t') << native_text(posting.module) << STR('\t')
+                                << native_text(posting.name) << STR('\t')
+                                << native_text({buf, ifc::util::format_to(buf, posting.decl)}) << STR('\n');
+                    }
+                    if (postings.empty())
+                        ++missing;
+                }
+                IFC_OUT << std::flush;
+                return missing == 0 ? 0 : 1;
+            }
+            catch (...)
+            {
+                report_exception(index_file.native());
+                return 2;
+            }
+        }
+    };
+
+    // -- Subcommand writing the precomputed layout of IFC files for the sgraph-js viewer,
+    //    see "ifc/dom/layout.hxx".  Each <file>.ifc becomes <dir>/<file>.ifclayout.
+    struct LayoutCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("layout"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            ifc::fs::path output_dir = STR(".");
+            std::vector<ifc::tool::StringView> files;
+            int error_count = 0;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("-o") and i + 1 < args.size())
+                {
+                    output_dir = args[++i];
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    ++error_count;
+                }
+                else
+                {
+                    files.push_back(arg);
+                }
+            }
+
+            for (auto& arg : files)
+            {
+                try
+                {
+                    ifc::fs::path path{arg};
+                    LoadedIfc ifc{path};
+                    ifc::Reader reader{ifc.input()};
+                    ifc::util::Loader loader{reader, ifc::util::LoadOrder::Address};
+                    const auto bytes = ifc::util::write_layout(loader.get(reader.ifc.header()->global_scope));
+                    store_output(output_dir, path, STR(".ifclayout"), [&](std::ostream& out) {
+                        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                    });
+                }
+                catch (...)
+                {
+                    report_exception(arg);
+                    ++error_count;
+                }
+            }
+            return error_count;
+        }
+    };
+
+    // -- Subcommand listing the modules an IFC depends on, directly or not, see "ifc/dom/modules.hxx".
+    struct ModulesCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("modules"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            unsigned jobs = 0;
+            std::vector<ifc::fs::path> directories;
+            std::optional<ifc::fs::path> index_file;
+            std::vector<ifc::tool::StringView> files;
+            int error_count = 0;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("-I") and i + 1 < args.size())
+                {
+                    directories.emplace_back(args[++i]);
+                }
+                else if (arg == STR("--index") and i + 1 < args.size())
+                {
+                    index_file = ifc::fs::path{args[++i]};
+                }
+                else if (arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 1;
+                    }
+                    jobs = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    ++error_count;
+                }
+                else
+                {
+                    files.push_back(arg);
+                }
+            }
+
+            // With an index, the directories are scanned once, and then only for the files that changed.
+            ifc::util::ModuleIndex index{directories};
+            auto resolver = ifc::util::search_path_resolver(directories);
+            if (index_file)
+            {
+                try
+                {
+                    index.load(*index_file);
+                    index.update();
+                    index.save(*index_file);
+                    resolver = index.resolver();
+                }
+                catch (...)
+                {
+                    report_exception(index_file->native());
+                    return 1;
+                }
+            }
+            for (auto& arg : files)
+            {
+                try
+                {
+                    const ifc::util::ModuleSet set{ifc::fs::path{arg}, resolver, jobs};
+                    IFC_OUT << arg << STR(":") << std::endl;
+                    // One line per module, dependencies first, then its imports.
+                    for (auto index : set.dependency_order())
+                    {
+                        const auto& module = set[index];
+                        IFC_OUT << native_text(ifc::util::to_string(module.name)) << STR('\t') << module.path.native()
+                                << STR('\n');
+                        for (auto dependency : module.dependencies)
+                            IFC_OUT << STR("    ") << native_text(ifc::util::to_string(set[dependency].name))
+                                    << STR('\n');
+                        for (const auto& missing : module.unresolved)
+                            IFC_OUT << STR("    ") << native_text(ifc::util::to_string(missing))
+                                    << STR(" (not found)\n");
+                    }
+                    IFC_OUT << std::endl;
+                }
+                catch (...)
+                {
+                    report_exception(arg);
+                    ++error_count;
+                }
+            }
+            return error_count;
+        }
+    };
+
+    // -- Subcommand reporting where the bytes of IFC files go, see "ifc/dom/stats.hxx".
+    struct StatsCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("stats"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            unsigned top = 10;
+            std::vector<ifc::tool::StringView> files;
+            int error_count = 0;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (arg == STR("--top") and i + 1 < args.size())
+                {
+                    auto count = parse_count(args[++i]);
+                    if (not count)
+                    {
+                        IFC_ERR << STR("invalid scope count ") << args[i] << std::endl;
+                        return 1;
+                    }
+                    top = *count;
+                }
+                else if (resemble_option(arg))
+                {
+                    IFC_ERR << STR("invalid option ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    ++error_count;
+                }
+                else
+                {
+                    files.push_back(arg);
+                }
+            }
+
+            for (auto& arg : files)
+            {
+                try
+                {
+                    LoadedIfc ifc{ifc::fs::path{arg}};
+                    ifc::Reader reader{ifc.input()};
+                    const auto stats = ifc::util::compute_stats(reader, top);
+                    std::ostringstream report;
+                    ifc::util::print_stats(stats, report);
+                    IFC_OUT << arg << STR(":") << std::endl << native_text(report.str()) << std::endl;
+                }
+                catch (...)
+                {
+                    report_exception(arg);
+                    ++error_count;
+                }
+            }
+            return error_count;
+        }
+    };
+
     // -- Subcommand printing the Spec version from an IFC file.
     struct VersionCommand : ifc::tool::Extension {
-        ifc::tool::Name name() const final { return STR("version"); }
+        constexpr ifc::tool::Name name() const final { return STR("version"); }
         int run_with(const ifc::tool::Arguments& args) const final
         {
             int error_count = 0;
@@ -101,10 +878,26 @@ namespace {
         }
     };
 
+    constexpr DiffCommand diff_cmd { };
+    constexpr ExportCommand export_cmd { };
+    constexpr GrepCommand grep_cmd { };
+    constexpr HashCommand hash_cmd { };
+    constexpr IndexCommand index_cmd { };
+    constexpr LayoutCommand layout_cmd { };
+    constexpr ModulesCommand modules_cmd { };
+    constexpr StatsCommand stats_cmd { };
     constexpr VersionCommand version_cmd { };
 
     // -- List of all builtin subcommands, sorted by their name.
     constexpr const ifc::tool::Extension* builtin_extensions[] {
+        &diff_cmd,
+        &export_cmd,
+        &grep_cmd,
+        &hash_cmd,
+        &index_cmd,
+        &layout_cmd,
+        &modules_cmd,
+        &stats_cmd,
         &version_cmd,
     };
     static_assert(std::ranges::is_sorted(builtin_extensions, { }, &ifc::tool::Extension::name));
@@ -117,6 +910,118 @@ namespace {
         return nullptr;
     }
 
+    // -- A subcommand extension loaded from a shared object, which stays loaded for the
+    //    lifetime of this object.
+    class SharedExtension {
+    public:
+        explicit SharedExtension(const ifc::fs::path& path)
+        {
+#ifdef WIN32
+            handle = LoadLibraryW(path.c_str());
+            if (handle != nullptr)
+                if (auto entry = GetProcAddress(handle, ifc::tool::extension_entry))
+                    ext = reinterpret_cast<ifc::tool::ExtensionEntry>(entry)();
+#else
+            handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (handle != nullptr)
+                if (auto entry = dlsym(handle, ifc::tool::extension_entry))
+                    ext = reinterpret_cast<ifc::tool::ExtensionEntry>(entry)();
+#endif
+        }
+
+        SharedExtension(const SharedExtension&) = delete;
+        SharedExtension& operator=(const SharedExtension&) = delete;
+
+        ~SharedExtension()
+        {
+            if (handle == nullptr)
+                return;
+#ifdef WIN32
+            FreeLibrary(handle);
+#else
+            dlclose(handle);
+#endif
+        }
+
+        const ifc::tool::Extension* extension() const { return ext; }
+
+    private:
+#ifdef WIN32
+        HMODULE handle = nullptr;
+#else
+        void* handle = nullptr;
+#endif
+        const ifc::tool::Extension* ext = nullptr;
+    };
+
+    // -- The subcommands run in this process: the builtin ones, those linked in, and those
+    //    loaded from shared objects, in that order of precedence.
+    class Registry {
+    public:
+        explicit Registry(const ifc::fs::path& prog) : tool_dir(program_path(prog).parent_path()) {}
+
+        const ifc::tool::Extension* find(const ifc::tool::Name& cmd)
+        {
+            if (auto op = builtin_operation(cmd))
+                return op;
+            for (auto ext : ifc::tool::linked_extensions())
+            {
+                if (ext->name() == cmd)
+                    return ext;
+            }
+            return load(cmd);
+        }
+
+    private:
+        static ifc::fs::path program_path(const ifc::fs::path& prog)
+        {
+#ifdef WIN32
+            wchar_t buf[MAX_PATH];
+            if (auto n = GetModuleFileNameW(nullptr, buf, MAX_PATH); n != 0 and n < MAX_PATH)
+                return ifc::fs::path{buf, buf + n};
+#else
+            std::error_code ec;
+            if (auto path = ifc::fs::read_symlink("/proc/self/exe", ec); not ec)
+                return path;
+#endif
+            return prog;
+        }
+
+        // Load the shared object for the subcommand, once.
+        const ifc::tool::Extension* load(const ifc::tool::Name& cmd)
+        {
+            ifc::tool::String key{cmd};
+            if (auto it = loaded.find(key); it != loaded.end())
+                return named(*it->second, cmd);
+
+#ifdef WIN32
+            ifc::tool::String file = STR("ifc-");
+            file += cmd;
+            file += STR(".dll");
+#else
+            ifc::tool::String file = STR("libifc-");
+            file += cmd;
+            file += STR(".so");
+#endif
+            auto shared = std::make_unique<SharedExtension>(tool_dir / file);
+            if (shared->extension() == nullptr)
+                shared = std::make_unique<SharedExtension>(file);
+            return named(*loaded.emplace(std::move(key), std::move(shared)).first->second, cmd);
+        }
+
+        // The extension of the shared object, if it implements the subcommand.
+        static const ifc::tool::Extension* named(const SharedExtension& shared, const ifc::tool::Name& cmd)
+        {
+            auto ext = shared.extension();
+            if (ext != nullptr and ext->name() == cmd)
+                return ext;
+            return nullptr;
+        }
+
+        ifc::fs::path tool_dir;
+        std::map<ifc::tool::String, std::unique_ptr<SharedExtension>> loaded;
+    };
+
     // Enclose the argument in double quotes.
     ifc::tool::String quote(const ifc::tool::StringView& s)
     {
@@ -126,12 +1031,103 @@ namespace {
         r += kwote_str;
         return r;
     }
+
+    // -- Run the subcommand `cmd` with its arguments: in process when it is known to the
+    //    registry, otherwise as the separate program ifc-<cmd>.
+    int run_subcommand(Registry& registry, const ifc::tool::Name& cmd, const ifc::tool::Arguments& args)
+    {
+        // It shall not contain any path separator character.
+        if (cmd.contains(STR("/")[0]) or cmd.contains(STR("\\")[0]))
+        {
+            IFC_ERR << STR("ifc subcommand cannot contain pathname separator") << std::endl;
+            return 1;
+        }
+
+        if (auto op = registry.find(cmd))
+            return op->run_with(args);
+
+        ifc::tool::String tool = STR("ifc-");
+        tool += cmd;
+        ifc::tool::String command = quote(tool);
+        for (auto& arg : args)
+        {
+            command += STR(" ");
+            command += quote(arg);
+        }
+
+        // The output of this process goes first.
+        IFC_OUT.flush();
+#ifdef WIN32
+        auto status = _wsystem(command.c_str());
+#else
+        auto status = system(command.c_str());
+#endif
+        if (status != 0)
+            IFC_ERR << STR("ifc: no subcommand named '") << cmd << STR("'") << std::endl;
+        return status;
+    }
+
+    // -- Split a command line of the batch mode into words, separated by blanks.
+    //    Double quotes enclose a word containing blanks.
+    std::vector<ifc::tool::String> split_command(const ifc::tool::StringView& line)
+    {
+        std::vector<ifc::tool::String> words;
+        std::size_t i = 0;
+        while (true)
+        {
+            while (i < line.size() and (line[i] == STR(' ') or line[i] == STR('\t') or line[i] == STR('\r')))
+                ++i;
+            if (i == line.size())
+                break;
+            auto& word = words.emplace_back();
+            bool quoted = false;
+            for (; i < line.size(); ++i)
+            {
+                const auto c = line[i];
+                if (c == STR('"'))
+                    quoted = not quoted;
+                else if (not quoted and (c == STR(' ') or c == STR('\t') or c == STR('\r')))
+                    break;
+                else
+                    word += c;
+            }
+        }
+        return words;
+    }
+
+    // -- Run the commands read from the standard input, one per line, each as <cmd> [options] <ifc-files>.
+    //    Blank lines and lines starting with '#' are ignored.  Return 1 if any command failed,
+    //    after reporting how many did: an exit status keeps only 8 bits of the count.
+    int run_batch(Registry& registry)
+    {
+        int failure_count = 0;
+        ifc::tool::String line;
+        while (std::getline(IFC_IN, line))
+        {
+            if (line.starts_with(STR("#")))
+                continue;
+            auto words = split_command(line);
+            if (words.empty())
+                continue;
+            ifc::tool::Arguments args { words.begin() + 1, words.end() };
+            if (run_subcommand(registry, words.front(), args) != 0)
+                ++failure_count;
+        }
+        if (failure_count == 0)
+            return 0;
+        IFC_ERR << failure_count << STR(" of the batch commands failed") << std::endl;
+        return 1;
+    }
 }
 
 
 int IFC_MAIN(int argc, ifc::tool::NativeChar* argv[])
 {
-    // The `ifc` tool itself does not accept any option.
+    Registry registry { argv[0] };
+    if (argc == 2 and ifc::tool::StringView{argv[1]} == STR("--batch"))
+        return run_batch(registry);
+
+    // Otherwise, the `ifc` tool itself does not accept any option.
     int idx = 1;
     while (idx < argc)
     {
@@ -147,36 +1143,8 @@ int IFC_MAIN(int argc, ifc::tool::NativeChar* argv[])
         return 1;
     }
 
-    // The subcommand name is next, after possibly invalid options.
-    // It shall not contain any path separator character.
+    // The subcommand name is next.
     ifc::tool::Name cmd { argv[idx] };
-    if (cmd.contains(STR("/")[0]) or cmd.contains(STR("\\")[0]))
-    {
-        IFC_ERR << STR("ifc subcommand cannot contain pathname separator") << std::endl;
-        return 1;
-    }
-
     ifc::tool::Arguments args { argv + idx + 1, argv + argc };
-
-    if (auto op = builtin_operation(cmd))
-        return op->run_with(args);
-
-    ifc::tool::String tool = STR("ifc-");
-    tool += cmd;
-    ifc::tool::String command = quote(tool);
-    for (auto& arg : args)
-    {
-        command += STR(" ");
-        command += quote(arg);
-    }
-
-#ifdef WIN32
-    auto status = _wsystem(command.c_str());
-#else
-    auto status = system(command.c_str());
-#endif
-    if (status != 0)
-        IFC_ERR << STR("ifc: no subcommand named '") << cmd << STR("'") << std::endl;
-    return status;
+    return run_subcommand(registry, cmd, args);
 }
-
@@ -0,0 +1,629 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// The `ifc serve` and `ifc query` subcommands: a process keeping IFC files open, and its client.
+//
+// The server listens on a Unix-domain socket, and keeps the files it is asked about open
+// (see "ifc/dom/repository.hxx"), so that the next queries about them need not read them
+// again.  Each connection can carry any number of requests, answered in order.
+//
+// A request and its reply are each sent as a frame: a 32-bit little-endian byte count, then
+// the bytes.  The bytes of a request are its words, each followed by a NUL character.  Those
+// of a reply are "ok" or "error: <message>", then the lines of the answer, each ended by a
+// newline; the fields of a line are separated by tabs.  The requests are:
+//
+//      lookup <file> <name>      kind, name, declaration and structural hash of the entity of that
+//                                qualified name and of its overloads
+//      scope <file> [<name>]     nested namespaces and entities of a namespace, the global one by default
+//      decl <file> <name>        the DOM properties of the declarations of that name
+//      deps <file>               modules imported and exported, with their files if found
+//      diff <file> <file>        entities added (+), removed (-) or changed (~), as in `ifc diff --all`
+//      files                     files kept open
+//      stop                      stop the server
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef WIN32
+#   include <winsock2.h>
+#   include <afunix.h>
+#else
+#   include <sys/socket.h>
+#   include <sys/un.h>
+#   include <unistd.h>
+#endif
+
+#include "ifc/file.hxx"
+#include "ifc/reader.hxx"
+#include "ifc/tooling.hxx"
+#include "ifc/dom/interface.hxx"
+#include "ifc/dom/modules.hxx"
+#include "ifc/dom/node.hxx"
+#include "ifc/dom/repository.hxx"
+#include "ifc/dom/resolver.hxx"
+
+#ifdef WIN32
+#   define STR(S) L ## S
+#   define IFC_ERR std::wcerr
+#else
+#   define STR(S) S
+#   define IFC_ERR std::cerr
+#endif
+
+namespace {
+#ifdef WIN32
+    using Socket = SOCKET;
+    constexpr Socket no_socket = INVALID_SOCKET;
+    constexpr int shutdown_both = SD_BOTH;
+
+    void close_socket(Socket s) { closesocket(s); }
+
+    // -- Winsock is started for the lifetime of this object.
+    struct SocketLibrary {
+        SocketLibrary()
+        {
+            WSADATA data;
+            if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+                throw "couldn't start Winsock";
+        }
+        ~SocketLibrary() { WSACleanup(); }
+    };
+#else
+    using Socket = int;
+    constexpr Socket no_socket = -1;
+    constexpr int shutdown_both = SHUT_RDWR;
+
+    void close_socket(Socket s) { ::close(s); }
+
+    struct SocketLibrary { };
+#endif
+
+    // -- Largest frame accepted, as a guard against a stray client.
+    constexpr uint32_t max_frame = 64u << 20;
+
+    ifc::fs::path default_socket_path()
+    {
+        return ifc::fs::temp_directory_path() / "ifc.sock";
+    }
+
+    sockaddr_un socket_address(const ifc::fs::path& path)
+    {
+        sockaddr_un address { };
+        address.sun_family = AF_UNIX;
+        const auto name = path.u8string();
+        if (name.size() >= sizeof address.sun_path)
+            throw "socket path too long";
+        std::memcpy(address.sun_path, name.data(), name.size());
+        return address;
+    }
+
+    // -- This predicate holds if the file, not followed if a link, is a Unix-domain socket.
+    bool is_socket_file(const ifc::fs::path& path)
+    {
+        std::error_code ec;
+        const auto status = ifc::fs::symlink_status(path, ec);
+#ifdef WIN32
+        // The standard library does not tell socket files, which are reparse points, from other files.
+        return not ec and not ifc::fs::is_regular_file(status) and not ifc::fs::is_directory(status)
+               and not ifc::fs::is_symlink(status);
+#else
+        return not ec and ifc::fs::is_socket(status);
+#endif
+    }
+
+    // -- What the accept loop does after a failed accept.
+    enum class AcceptFailure {
+        Retry,   // the call was interrupted, or the peer left before it was accepted
+        Wait,    // descriptors or buffers are exhausted, until a connection ends
+        Fatal,
+    };
+
+    AcceptFailure accept_failure()
+    {
+#ifdef WIN32
+        switch (WSAGetLastError())
+        {
+        case WSAEINTR:
+        case WSAECONNRESET:
+            return AcceptFailure::Retry;
+        case WSAEMFILE:
+        case WSAENOBUFS:
+            return AcceptFailure::Wait;
+        }
+#else
+        switch (errno)
+        {
+        case EINTR:
+        case ECONNABORTED:
+            return AcceptFailure::Retry;
+        case EMFILE:
+        case ENFILE:
+        case ENOBUFS:
+        case ENOMEM:
+            return AcceptFailure::Wait;
+        }
+#endif
+        return AcceptFailure::Fatal;
+    }
+
+    bool read_exact(Socket s, char* bytes, std::size_t count)
+    {
+        while (count != 0)
+        {
+            const auto n = ::recv(s, bytes, static_cast<int>(std::min<std::size_t>(count, 1u << 20)), 0);
+            if (n <= 0)
+                return false;
+            bytes += n;
+            count -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool write_all(Socket s, const char* bytes, std::size_t count)
+    {
+        while (count != 0)
+        {
+            const auto n = ::send(s, bytes, static_cast<int>(std::min<std::size_t>(count, 1u << 20)), 0);
+            if (n <= 0)
+                return false;
+            bytes += n;
+            count -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // -- The next frame on the socket; nothing if the peer is gone, or broke the protocol.
+    std::optional<std::string> receive_frame(Socket s)
+    {
+        unsigned char prefix[4];
+        if (not read_exact(s, reinterpret_cast<char*>(prefix), sizeof prefix))
+            return std::nullopt;
+        const uint32_t size = prefix[0] | prefix[1] << 8 | prefix[2] << 16 | uint32_t{prefix[3]} << 24;
+        if (size > max_frame)
+            return std::nullopt;
+        std::string bytes(size, '\0');
+        if (not read_exact(s, bytes.data(), bytes.size()))
+            return std::nullopt;
+        return bytes;
+    }
+
+    bool send_frame(Socket s, std::string_view bytes)
+    {
+        const auto size = static_cast<uint32_t>(bytes.size());
+        const unsigned char prefix[4] = {
+            static_cast<unsigned char>(size), static_cast<unsigned char>(size >> 8),
+            static_cast<unsigned char>(size >> 16), static_cast<unsigned char>(size >> 24),
+        };
+        return write_all(s, reinterpret_cast<const char*>(prefix), sizeof prefix)
+               and write_all(s, bytes.data(), bytes.size());
+    }
+
+    std::vector<std::string> split_words(std::string_view bytes)
+    {
+        std::vector<std::string> words;
+        for (std::size_t start = 0; start < bytes.size();)
+        {
+            auto end = bytes.find('\0', start);
+            if (end == std::string_view::npos)
+                end = bytes.size();
+            words.emplace_back(bytes.substr(start, end - start));
+            start = end + 1;
+        }
+        return words;
+    }
+
+    // -- Text of the exception being handled.
+    std::string exception_text()
+    {
+        try
+        {
+            throw;
+        }
+        catch (const ifc::IfcArchMismatch&)
+        {
+            return "ifc architecture mismatch";
+        }
+        catch (const ifc::IntegrityCheckFailed&)
+        {
+            return "integrity check failed";
+        }
+        catch (const ifc::IfcReadFailure& e)
+        {
+            return "couldn't read " + std::string{reinterpret_cast<const char*>(e.path.c_str())};
+        }
+        catch (const ifc::error_condition::UnexpectedVisitor& e)
+        {
+            return "visit unexpected " + std::string{e.category} + ": " + std::string{e.sort};
+        }
+        catch (const ifc::util::ModuleCycle& e)
+        {
+            std::string text = "modules import one another:";
+            for (const auto& name : e.names)
+                text.append(" ").append(name);
+            return text;
+        }
+        catch (const char* message)
+        {
+            return message;
+        }
+        catch (const std::exception& e)
+        {
+            return e.what();
+        }
+        catch (...)
+        {
+            return "unknown exception caught";
+        }
+    }
+
+    std::string hex(uint64_t value)
+    {
+        char buf[16];
+        auto end = std::to_chars(buf, buf + sizeof buf, value, 16).ptr;
+        return std::string(sizeof buf - static_cast<std::size_t>(end - buf), '0') + std::string{buf, end};
+    }
+
+    std::string key_text(ifc::util::NodeKey key)
+    {
+        char buf[ifc::util::format_buffer_size];
+        return {buf, ifc::util::format_to(buf, key)};
+    }
+
+    ifc::fs::path path_of(const std::string& word)
+    {
+        return ifc::fs::path{std::u8string{word.begin(), word.end()}};
+    }
+
+    // -- The state of `ifc serve`, shared by the threads serving the connections.
+    class Server {
+    public:
+        Server(std::vector<ifc::fs::path> directories, unsigned jobs) : repository(jobs), index(std::move(directories))
+        {
+            index.update();
+        }
+
+        int run(const ifc::fs::path& path)
+        {
+            listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listener == no_socket)
+                throw "couldn't create a socket";
+            address = socket_address(path);
+            // A socket file left by a server that is gone is replaced; any other file is left alone.
+            std::error_code ec;
+            if (ifc::fs::exists(ifc::fs::symlink_status(path, ec)))
+            {
+                if (not is_socket_file(path))
+                    throw "not a socket";
+                if (connects_to(address))
+                    throw "a server is already listening on that socket";
+                ifc::fs::remove(path, ec);
+            }
+            if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof address) != 0
+                or ::listen(listener, SOMAXCONN) != 0)
+            {
+                close_socket(listener);
+                throw "couldn't listen on the socket";
+            }
+
+            // Each connection is served by a thread of its own, which is not joined: its end is
+            // counted, and waited for before returning.
+            int status = 0;
+            while (running)
+            {
+                const auto peer = ::accept(listener, nullptr, nullptr);
+                if (peer == no_socket)
+                {
+                    const auto failure = accept_failure();
+                    if (failure == AcceptFailure::Wait)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    }
+                    else if (failure == AcceptFailure::Fatal and running)
+                    {
+                        IFC_ERR << STR("couldn't accept a connection on the socket") << std::endl;
+                        status = 1;
+                        stop();
+                    }
+                    continue;
+                }
+                std::lock_guard lock{mutex};
+                if (not running)
+                {
+                    close_socket(peer);
+                    break;
+                }
+                connections.insert(peer);
+                std::thread{[this, peer] { serve(peer); }}.detach();
+            }
+            {
+                std::unique_lock lock{mutex};
+                served.wait(lock, [this] { return connections.empty(); });
+            }
+            close_socket(listener);
+            ifc::fs::remove(path, ec);
+            return status;
+        }
+
+    private:
+        ifc::util::Repository repository;
+        ifc::util::ModuleIndex index;
+        std::mutex index_mutex;
+        Socket listener = no_socket;
+        sockaddr_un address { };
+        std::atomic<bool> running { true };
+        std::mutex mutex;
+        std::set<Socket> connections; // those being served
+        std::condition_variable served;
+
+        static bool connects_to(const sockaddr_un& address)
+        {
+            const auto s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (s == no_socket)
+                return false;
+            const bool connected = ::connect(s, reinterpret_cast<const sockaddr*>(&address), sizeof address) == 0;
+            close_socket(s);
+            return connected;
+        }
+
+        void serve(Socket peer)
+        {
+            while (auto request = receive_frame(peer))
+            {
+                const auto words = split_words(*request);
+                std::string reply;
+                try
+                {
+                    reply = "ok\n" + answer(words);
+                }
+                catch (...)
+                {
+                    reply = "error: " + exception_text() + "\n";
+                }
+                if (not send_frame(peer, reply))
+                    break;
+                if (not words.empty() and words[0] == "stop")
+                    stop();
+            }
+            std::lock_guard lock{mutex};
+            connections.erase(peer);
+            close_socket(peer);
+            served.notify_all();
+        }
+
+        // Wake the threads blocked on the listener and on the connections.  A shutdown does not
+        // wake an accept on every system, but a connection does: the accept loop then sees that
+        // it is to stop, and closes it.
+        void stop()
+        {
+            std::lock_guard lock{mutex};
+            if (running.exchange(false))
+                connects_to(address);
+            for (auto s : connections)
+                ::shutdown(s, shutdown_both);
+        }
+
+        std::string answer(const std::vector<std::string>& words)
+        {
+            if (words.empty())
+                throw "empty request";
+            const auto& query = words[0];
+            auto expect = [&](std::size_t min, std::size_t max) {
+                if (words.size() < min + 1 or words.size() > max + 1)
+                    throw "wrong number of arguments";
+            };
+
+            std::string text;
+            if (query == "lookup")
+            {
+                expect(2, 2);
+                const auto file = repository.open(path_of(words[1]));
+                for (const auto& entity : file->find(words[2]))
+                    text.append(entity.kind).append("\t").append(entity.name).append("\t")
+                        .append(key_text(entity.decl)).append("\t").append(hex(entity.hash)).append("\n");
+            }
+            else if (query == "scope")
+            {
+                expect(1, 2);
+                const auto file = repository.open(path_of(words[1]));
+                const std::string scope = words.size() > 2 ? words[2] : std::string{};
+                const auto prefix = scope.empty() ? scope : scope + "::";
+                std::set<std::string> nested;
+                for (const auto& entity : file->entities)
+                {
+                    if (entity.scope == scope)
+                        text.append(entity.kind).append("\t").append(entity.name).append("\n");
+                    else if (entity.scope.starts_with(prefix))
+                        nested.insert(entity.scope.substr(0, entity.scope.find("::", prefix.size())));
+                }
+                for (const auto& name : nested)
+                    text.append("namespace\t").append(name).append("\n");
+            }
+            else if (query == "decl")
+            {
+                expect(2, 2);
+                const auto file = repository.open(path_of(words[1]));
+                ifc::util::Loader ctx { file->module->reader() };
+                for (const auto& entity : file->find(words[2]))
+                {
+                    const auto& node = ctx.get(ifc::util::NodeKey{entity.decl});
+                    text.append(key_text(entity.decl)).append("\t").append(entity.name).append("\n");
+                    for (const auto& [name, value] : node.props)
+                        text.append("\t").append(name).append("\t").append(value).append("\n");
+                }
+            }
+            else if (query == "deps")
+            {
+                expect(1, 1);
+                const auto file = repository.open(path_of(words[1]));
+                std::lock_guard lock{index_mutex};
+                index.update();
+                for (const auto& name : ifc::util::module_dependencies(file->module->reader()))
+                {
+                    const auto path = index.find(name);
+                    const auto u8path = path ? path->generic_u8string() : std::u8string{u8"(not found)"};
+                    text.append(ifc::util::to_string(name)).append("\t")
+                        .append(reinterpret_cast<const char*>(u8path.c_str())).append("\n");
+                }
+            }
+            else if (query == "diff")
+            {
+                expect(2, 2);
+                const auto before = repository.open(path_of(words[1]));
+                const auto after = repository.open(path_of(words[2]));
+                for (const auto& change : ifc::util::diff_entities(before->entities, after->entities))
+                {
+                    constexpr const char* marks[] = {"+", "-", "~"};
+                    text.append(marks[std::to_underlying(change.change)]).append("\t").append(change.kind)
+                        .append("\t").append(change.name).append("\n");
+                }
+            }
+            else if (query == "files")
+            {
+                expect(0, 0);
+                for (const auto& path : repository.files())
+                    text.append(reinterpret_cast<const char*>(path.generic_u8string().c_str())).append("\n");
+            }
+            else if (query == "stop")
+            {
+                expect(0, 0);
+            }
+            else
+            {
+                throw "unknown request";
+            }
+            return text;
+        }
+    };
+
+    // -- Parse the --socket option at args[i], if that is what it is.
+    bool parse_socket_option(const ifc::tool::Arguments& args, std::size_t& i, ifc::fs::path& socket)
+    {
+        if (args[i] != STR("--socket") or i + 1 == args.size())
+            return false;
+        socket = ifc::fs::path{args[++i]};
+        return true;
+    }
+
+    // -- Subcommand running the query server until it is asked to stop.
+    struct ServeCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("serve"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            auto socket = default_socket_path();
+            std::vector<ifc::fs::path> directories;
+            unsigned jobs = 0;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                const auto& arg = args[i];
+                if (parse_socket_option(args, i, socket))
+                    continue;
+                if (arg == STR("-I") and i + 1 < args.size())
+                {
+                    directories.emplace_back(args[++i]);
+                }
+                else if (arg == STR("--jobs") and i + 1 < args.size())
+                {
+                    const auto count = ifc::fs::path{args[++i]}.string();
+                    const auto last = count.data() + count.size();
+                    if (std::from_chars(count.data(), last, jobs).ptr != last or jobs == 0)
+                    {
+                        IFC_ERR << STR("invalid job count ") << args[i] << std::endl;
+                        return 1;
+                    }
+                }
+                else
+                {
+                    IFC_ERR << STR("invalid argument ") << arg
+                            << STR(" to ifc subcommand ")
+                            << name() << std::endl;
+                    return 1;
+                }
+            }
+
+            try
+            {
+                [[maybe_unused]] SocketLibrary library;
+                Server server { std::move(directories), jobs };
+                return server.run(socket);
+            }
+            catch (...)
+            {
+                IFC_ERR << socket.native() << STR(": ") << ifc::fs::path{exception_text()}.native() << std::endl;
+                return 1;
+            }
+        }
+    };
+
+    // -- Subcommand sending one request to the query server, and printing the answer.
+    struct QueryCommand : ifc::tool::Extension {
+        constexpr ifc::tool::Name name() const final { return STR("query"); }
+        int run_with(const ifc::tool::Arguments& args) const final
+        {
+            auto socket = default_socket_path();
+            std::string request;
+            for (std::size_t i = 0; i < args.size(); ++i)
+            {
+                if (request.empty() and parse_socket_option(args, i, socket))
+                    continue;
+                const auto word = ifc::fs::path{args[i]}.u8string();
+                request.append(reinterpret_cast<const char*>(word.c_str()), word.size()).push_back('\0');
+            }
+
+            std::optional<std::string> reply;
+            try
+            {
+                [[maybe_unused]] SocketLibrary library;
+                const auto address = socket_address(socket);
+                const auto s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                if (s == no_socket)
+                    throw "couldn't create a socket";
+                if (::connect(s, reinterpret_cast<const sockaddr*>(&address), sizeof address) != 0)
+                {
+                    close_socket(s);
+                    throw "no server is listening on that socket";
+                }
+                if (send_frame(s, request))
+                    reply = receive_frame(s);
+                close_socket(s);
+            }
+            catch (...)
+            {
+                IFC_ERR << socket.native() << STR(": ") << ifc::fs::path{exception_text()}.native() << std::endl;
+                return 1;
+            }
+            if (not reply)
+            {
+                IFC_ERR << socket.native() << STR(": no reply") << std::endl;
+                return 1;
+            }
+
+            // The answer is narrow text.
+            const auto newline = reply->find('\n');
+            const std::string_view status = std::string_view{*reply}.substr(0, newline);
+            if (status != "ok")
+            {
+                std::cerr << status << std::endl;
+                return 1;
+            }
+            std::cout << std::string_view{*reply}.substr(newline + 1) << std::flush;
+            return 0;
+        }
+    };
+
+    constexpr ServeCommand serve_cmd { };
+    constexpr QueryCommand query_cmd { };
+    const ifc::tool::Registration serve_registration { serve_cmd };
+    const ifc::tool::Registration query_registration { query_cmd };
+}
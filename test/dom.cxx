@@ -0,0 +1,384 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gsl/gsl>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "ifc/dom/filter.hxx"
+#include "ifc/dom/grep.hxx"
+#include "ifc/dom/interface.hxx"
+#include "ifc/dom/merged.hxx"
+#include "ifc/dom/snapshot.hxx"
+#include "ifc/dom/symbols.hxx"
+#include "ifc/file.hxx"
+
+#include "synthetic.hxx"
+
+using namespace std::literals;
+using namespace ifc;
+
+// The library asserts through ifc_assert, which is otherwise provided by the tools.
+void ifc_assert(const char* text, const char* file, int line)
+{
+    fprintf(stderr, "assertion failure: ``%s'' in file ``%s'' at line %d\n", text, file, line);
+    REQUIRE(false);
+}
+
+namespace {
+    InputIfc input(const std::vector<std::byte>& bytes)
+    {
+        InputIfc file{gsl::span(bytes)};
+        // Any unit is accepted: a mismatch with the (empty) expected designator is not an error.
+        file.validate<UnitSort::Primary>(Pathname{}, Architecture::Unknown, Pathname{}, IfcOptions::IntegrityCheck);
+        REQUIRE(file.header() != nullptr);
+        return file;
+    }
+} // namespace
+
+TEST_CASE("Interfaces differing only in source locations are the same")
+{
+    const auto before = test::sample_ifc();
+    const auto after  = test::sample_ifc({.first_line = 8});
+    const auto a      = input(before);
+    const auto b      = input(after);
+    REQUIRE_FALSE(util::same_partitions(a, b));
+
+    // The function bodies have their own locations.
+    CHECK(util::diff_interfaces(a, b, true, 1).empty());
+    CHECK(util::diff_interfaces(a, b, false, 1).empty());
+}
+
+TEST_CASE("The semantic hash does not depend on source locations")
+{
+    const auto before = test::sample_ifc();
+    const auto after  = test::sample_ifc({.first_line = 8});
+    const auto other  = test::sample_ifc({.module = "other"});
+    const auto a      = input(before);
+    const auto b      = input(after);
+    CHECK(a.header()->content_hash.value != b.header()->content_hash.value);
+    CHECK(util::semantic_hash(a, 1).value == util::semantic_hash(b, 1).value);
+    CHECK(util::semantic_hash(a, 1).value != util::semantic_hash(input(other), 1).value);
+}
+
+TEST_CASE("Structural hashes of a cycle do not depend on the order of the entities")
+{
+    // f and g declare each other in their bodies.
+    const auto bytes   = test::sample_ifc();
+    const auto swapped = test::sample_ifc({.functions_swapped = true});
+    const auto ifc     = input(bytes);
+    const auto one     = util::interface_entities(ifc, true, 1);
+    REQUIRE(one.size() == 4);
+    CHECK(util::diff_entities(one, util::interface_entities(input(swapped), true, 1)).empty());
+    for (int run = 0; run < 20; ++run)
+        CHECK(util::diff_entities(one, util::interface_entities(ifc, true, 4)).empty());
+}
+
+namespace {
+    // Load every node reachable from the global scope, through children and references.
+    void load_all(util::Loader& loader)
+    {
+        std::vector<util::NodeKey> work{loader.reader.ifc.header()->global_scope};
+        std::set<util::NodeKey> seen{work.back()};
+        while (not work.empty())
+        {
+            const auto& node = loader.get(work.back());
+            work.pop_back();
+            for (const auto* child : node.children)
+                if (seen.insert(child->key).second)
+                    work.push_back(child->key);
+            for (auto key : node.references)
+                if (seen.insert(key).second)
+                    work.push_back(key);
+        }
+    }
+
+    void check_same(const util::Node& a, const util::Node& b)
+    {
+        CHECK(a.key == b.key);
+        CHECK(a.id == b.id);
+        CHECK(a.props == b.props);
+        CHECK(a.references == b.references);
+        REQUIRE(a.children.size() == b.children.size());
+        for (std::size_t i = 0; i < a.children.size(); ++i)
+            CHECK(a.children[i]->key == b.children[i]->key);
+    }
+
+    // A directory of its own for a test, removed with its contents at the end of the test.
+    struct TemporaryDirectory {
+        explicit TemporaryDirectory(std::string_view name)
+          : path(std::filesystem::temp_directory_path() / ("ifc-dom-test-" + std::string{name}))
+        {
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+
+        const std::filesystem::path path;
+    };
+
+    std::vector<std::byte> read_file(const std::filesystem::path& path)
+    {
+        std::vector<std::byte> bytes(std::filesystem::file_size(path));
+        std::ifstream stream{path, std::ios_base::binary};
+        stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return bytes;
+    }
+
+    // Overwrite the object of type T at `offset` in the bytes.
+    template<typename T>
+    void patch(std::vector<std::byte>& bytes, std::size_t offset, const T& value)
+    {
+        std::memcpy(bytes.data() + offset, &value, sizeof value);
+    }
+} // namespace
+
+TEST_CASE("Nodes restored from a snapshot are those it was taken from")
+{
+    const auto bytes = test::sample_ifc();
+    const auto ifc   = input(bytes);
+    Reader reader{ifc};
+    util::Loader loader{reader};
+    load_all(loader);
+    const auto snapshot_bytes = util::write_snapshot(loader);
+
+    const util::Snapshot snapshot{snapshot_bytes};
+    CHECK(snapshot.matches(*ifc.header()));
+    util::Loader restored{reader};
+    restored.attach(snapshot);
+    REQUIRE(not snapshot.nodes().empty());
+    for (const auto& record : snapshot.nodes())
+    {
+        const auto key = util::NodeKey{record.key.kind, record.key.sort, record.key.index};
+        check_same(loader.get(key), restored.get(key));
+    }
+}
+
+TEST_CASE("Corrupted snapshots are rejected")
+{
+    const auto bytes = test::sample_ifc();
+    const auto ifc   = input(bytes);
+    Reader reader{ifc};
+    util::Loader loader{reader};
+    load_all(loader);
+    const auto good = util::write_snapshot(loader);
+    CHECK_NOTHROW(util::Snapshot{good});
+
+    util::snapshot::Header header;
+    std::memcpy(&header, good.data(), sizeof header);
+    REQUIRE(header.node_count > 1);
+    REQUIRE(header.property_count > 0);
+    const auto nodes      = sizeof header;
+    const auto properties = nodes + header.node_count * sizeof(util::snapshot::NodeRecord);
+    const auto edges      = properties + header.property_count * sizeof(util::snapshot::PropertyRecord);
+    const auto node_field = [&](std::size_t member) { return nodes + sizeof(util::snapshot::NodeRecord) + member; };
+
+    auto corrupted = [&](std::size_t offset, auto value) {
+        auto copy = good;
+        patch(copy, offset, value);
+        CHECK_THROWS_AS(util::Snapshot{copy}, util::InvalidSnapshot);
+    };
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, first_property)), uint32_t{0xFFFFFFF0});
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, child_count)), header.edge_count + 1);
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, first_reference)), header.edge_count + 1);
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, reference_count)), uint32_t{0xFFFFFFFF});
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, id)), util::snapshot::StringRef{header.string_bytes, 1});
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, key)), util::snapshot::Key{util::SortKind(42), 0, 0});
+    // The records are no longer sorted.
+    corrupted(node_field(offsetof(util::snapshot::NodeRecord, key)),
+              reinterpret_cast<const util::snapshot::NodeRecord*>(good.data() + nodes)->key);
+    corrupted(properties + offsetof(util::snapshot::PropertyRecord, value),
+              util::snapshot::StringRef{0, header.string_bytes + 1});
+    if (header.edge_count != 0)
+        corrupted(edges, util::snapshot::Key{util::SortKind::Expr, 0xFFFF, 0});
+
+    auto truncated = good;
+    truncated.resize(truncated.size() - 1);
+    CHECK_THROWS_AS(util::Snapshot{truncated}, util::InvalidSnapshot);
+}
+
+TEST_CASE("Damaged filter caches are read as empty")
+{
+    const TemporaryDirectory dir{"filters"};
+    const auto file    = dir.path / "ifc.filters";
+    const auto bytes   = test::sample_ifc();
+    const auto& header = *input(bytes).header();
+    {
+        util::FilterCache cache{file};
+        cache.insert(header.content_hash, util::IdentifierFilter{"\0deep\0next\0"sv});
+        cache.save();
+    }
+    {
+        const util::FilterCache cache{file};
+        CHECK(cache.may_contain(header.content_hash, "deep") == true);
+    }
+
+    // Signature, content hash, then the count of words.
+    const auto good         = read_file(file);
+    const auto count_offset = 16 + sizeof(SHA256Hash);
+    auto read_damaged       = [&](const std::vector<std::byte>& damaged) {
+        test::write_file(file, damaged);
+        const util::FilterCache cache{file};
+        CHECK_FALSE(cache.may_contain(header.content_hash, "deep").has_value());
+    };
+    auto huge = good;
+    patch(huge, count_offset, uint32_t{0xFFFFFFF8});
+    read_damaged(huge);
+    auto larger = good;
+    patch(larger, count_offset, static_cast<uint32_t>((good.size() - count_offset) / 4 + 8) / 8 * 8);
+    read_damaged(larger);
+    read_damaged({good.begin(), good.end() - 4});
+}
+
+TEST_CASE("Damaged IFC files fail the search without ending it")
+{
+    const TemporaryDirectory dir{"grep"};
+    const auto bytes = test::sample_ifc();
+    test::write_file(dir.path / "good.ifc", bytes);
+    auto damaged = bytes;
+    patch(damaged, sizeof InterfaceSignature + offsetof(Header, string_table_size), uint32_t{0xFFFFFF00});
+    test::write_file(dir.path / "damaged.ifc", damaged);
+    // The header is whole, not the string table.
+    test::write_file(dir.path / "truncated.ifc", {bytes.begin(), bytes.begin() + sizeof InterfaceSignature + sizeof(Header)});
+    test::write_file(dir.path / "other.txt", std::vector<std::byte>(256));
+
+    const std::vector paths{dir.path / "damaged.ifc", dir.path / "good.ifc", dir.path / "other.txt",
+                            dir.path / "truncated.ifc"};
+    const util::SymbolPattern pattern{"N::deep", false};
+    std::vector<util::FileMatches> found;
+    REQUIRE_NOTHROW(found = util::grep_ifcs(paths, pattern, 2));
+    REQUIRE(found.size() == 3);
+    CHECK(found[0].failed);
+    CHECK(found[1].path == paths[1]);
+    CHECK_FALSE(found[1].failed);
+    REQUIRE(found[1].matches.size() == 1);
+    CHECK(found[1].matches[0].name == "N::deep");
+    CHECK(found[2].failed);
+}
+
+TEST_CASE("Symbol indices are built, queried and updated")
+{
+    const TemporaryDirectory dir{"symbols"};
+    const auto index = dir.path / "ifc.symbols";
+    std::filesystem::create_directories(dir.path / "lib");
+    test::write_file(dir.path / "a.ifc", test::sample_ifc({.module = "a"}));
+    test::write_file(dir.path / "lib" / "b.ifc", test::sample_ifc({.module = "b"}));
+    test::write_file(dir.path / "lib" / "junk.ifc", std::vector<std::byte>(64));
+
+    auto update = util::build_symbol_index({dir.path}, index, 2);
+    CHECK(update.scanned == 3);
+    CHECK(update.read == 2);
+    CHECK(update.removed == 0);
+    REQUIRE(update.failed.size() == 1);
+    CHECK(update.failed[0].filename() == "junk.ifc");
+    {
+        const util::SymbolIndex symbols{index};
+        CHECK(symbols.file_count() == 2);
+        const auto deep = symbols.find("deep");
+        REQUIRE(deep.size() == 2);
+        CHECK(deep[0].name == "N::deep");
+        CHECK(deep[0].path.ends_with("a.ifc"));
+        CHECK(deep[0].module == "a");
+        CHECK(deep[1].module == "b");
+        CHECK(symbols.find("::N::deep").size() == 2);
+        CHECK(symbols.find("N::S").size() == 2);
+        CHECK(symbols.find("f").size() == 2);
+        CHECK(symbols.find("N::f").empty());
+        CHECK(symbols.find("nothing").empty());
+    }
+
+    // Only the files not in the index are read again.
+    std::filesystem::remove(dir.path / "lib" / "b.ifc");
+    update = util::build_symbol_index({dir.path}, index, 2);
+    CHECK(update.scanned == 2);
+    CHECK(update.read == 0);
+    CHECK(update.removed == 1);
+    {
+        const util::SymbolIndex symbols{index};
+        CHECK(symbols.file_count() == 1);
+        const auto deep = symbols.find("deep");
+        REQUIRE(deep.size() == 1);
+        CHECK(deep[0].module == "a");
+    }
+}
+
+TEST_CASE("Corrupted symbol indices are rejected, then rebuilt")
+{
+    const TemporaryDirectory dir{"corrupted-symbols"};
+    const auto index = dir.path / "ifc.symbols";
+    test::write_file(dir.path / "a.ifc", test::sample_ifc());
+    util::build_symbol_index({dir.path}, index, 1);
+    const auto good = read_file(index);
+
+    auto corrupted = [&](std::vector<std::byte> bytes) {
+        test::write_file(index, bytes);
+        CHECK_THROWS_AS(util::SymbolIndex{index}, const char*);
+        // The index is built anew.
+        const auto update = util::build_symbol_index({dir.path}, index, 1);
+        CHECK(update.read == 1);
+        CHECK(util::SymbolIndex{index}.find("deep").size() == 1);
+    };
+    auto signature = good;
+    signature[0]   = std::byte{'X'};
+    corrupted(signature);
+    corrupted({good.begin(), good.end() - 1});
+    auto sections = good;
+    patch(sections, 16 + 2 * sizeof(uint32_t), uint64_t{good.size() + 1});
+    corrupted(sections);
+
+    // Postings are checked as they are read; those of "x", the last name, end the index.
+    CHECK(util::SymbolIndex{index}.find("x").size() == 1);
+    auto postings = good;
+    std::fill(postings.end() - 4, postings.end(), std::byte{0xFF});
+    test::write_file(index, postings);
+    const util::SymbolIndex symbols{index};
+    CHECK_THROWS_AS(symbols.find("x"), const char*);
+}
+
+TEST_CASE("Merged readers share the entities of the global module")
+{
+    // S is attached to the global module; f, g and deep to their modules.
+    const auto a_bytes = test::sample_ifc({.module = "a"});
+    const auto b_bytes = test::sample_ifc({.module = "b", .first_line = 8});
+    const auto a       = input(a_bytes);
+    const auto b       = input(b_bytes);
+    Reader a_reader{a};
+    Reader b_reader{b};
+    const util::MergedReader merged{{&a_reader, &b_reader}, false, 1};
+    CHECK(merged.files() == 2);
+
+    const auto s = merged.find("N::S");
+    REQUIRE(s.size() == 1);
+    CHECK(s[0].owner.empty());
+    REQUIRE(s[0].sources.size() == 2);
+    CHECK(s[0].sources[0].file == 0);
+    CHECK(s[0].sources[1].file == 1);
+
+    const auto deep = merged.find("N::deep");
+    REQUIRE(deep.size() == 2);
+    CHECK(deep[0].owner == "a");
+    CHECK(deep[1].owner == "b");
+    CHECK(deep[0].sources.size() == 1);
+    CHECK(deep[0].hash == deep[1].hash);
+
+    CHECK(merged.entities().size() == 7);
+    CHECK(merged.declarations() == 8);
+    REQUIRE(merged.global().scopes.size() == 1);
+    CHECK(merged.scope(merged.global().scopes[0]).name == "N");
+}
@@ -0,0 +1,269 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "printer.hxx"
+
+using namespace std::literals;
+using namespace ifc;
+
+// The library asserts through ifc_assert, which is otherwise provided by the tools.
+void ifc_assert(const char* text, const char* file, int line)
+{
+    fprintf(stderr, "assertion failure: ``%s'' in file ``%s'' at line %d\n", text, file, line);
+    REQUIRE(false);
+}
+
+namespace {
+    std::string json(std::string_view str)
+    {
+        std::string text;
+        {
+            util::OutputBuffer out{text};
+            util::write_json_string(out, str);
+        }
+        return text;
+    }
+
+    // The U+FFFD replacement character, in UTF-8.
+    constexpr auto replacement = "\xEF\xBF\xBD"sv;
+} // namespace
+
+TEST_CASE("JSON strings escape quotes, backslashes and control characters")
+{
+    CHECK(json("") == R"("")");
+    CHECK(json("plain") == R"("plain")");
+    CHECK(json(R"(say "hi")") == R"("say \"hi\"")");
+    CHECK(json(R"(a\b)") == R"("a\\b")");
+    CHECK(json("one\ntwo\tthree\r") == R"("one\ntwo\tthree\r")");
+    CHECK(json("\x01\x1F"sv) == R"("\u0001\u001f")");
+    CHECK(json("nul\0byte"sv) == R"("nul\u0000byte")");
+    CHECK(json("\x7F") == "\"\x7F\"");
+}
+
+TEST_CASE("JSON strings escape the characters anywhere in a long string")
+{
+    // The bytes are looked at eight at a time; each position in a word is tried.
+    for (std::size_t i = 0; i < 24; ++i)
+    {
+        std::string str(24, 'x');
+        str[i] = '"';
+        std::string expected(24, 'x');
+        expected.replace(i, 1, "\\\"");
+        CHECK(json(str) == '"' + expected + '"');
+    }
+}
+
+TEST_CASE("JSON strings keep well-formed UTF-8")
+{
+    for (auto str : {"caf\xC3\xA9"sv, "\xE2\x82\xAC"sv, "\xED\x9F\xBF"sv, "\xEE\x80\x80"sv, "\xF0\x9F\x98\x80"sv,
+                     "\xF4\x8F\xBF\xBF"sv})
+        CHECK(json(str) == '"' + std::string{str} + '"');
+    // A sequence across words.
+    const auto str = "1234567\xF0\x9F\x98\x80 and \xE2\x82\xAC\"!"s;
+    CHECK(json(str) == "\"1234567\xF0\x9F\x98\x80 and \xE2\x82\xAC\\\"!\"");
+}
+
+TEST_CASE("JSON strings replace ill-formed UTF-8")
+{
+    const auto r = std::string{replacement};
+    // A lone continuation byte, and bytes that are never in UTF-8.
+    CHECK(json("a\x80z") == "\"a" + r + "z\"");
+    CHECK(json("\xC0\xAF") == '"' + r + r + '"');
+    CHECK(json("\xF5\x80") == '"' + r + r + '"');
+    CHECK(json("\xFF") == '"' + r + '"');
+    // Overlong forms and surrogates: the lead byte alone is a maximal subpart.
+    CHECK(json("\xE0\x80\x80") == '"' + r + r + r + '"');
+    CHECK(json("\xED\xA0\x80") == '"' + r + r + r + '"');
+    CHECK(json("\xF0\x80\x80\x80") == '"' + r + r + r + r + '"');
+    CHECK(json("\xF4\x90\x80\x80") == '"' + r + r + r + r + '"');
+    // A truncated sequence is one maximal subpart, followed or not by more text.
+    CHECK(json("\xE2\x82") == '"' + r + '"');
+    CHECK(json("\xE2\x82z") == '"' + r + "z\"");
+    CHECK(json("\xF0\x9F\x98\"") == '"' + r + "\\\"\"");
+    CHECK(json("1234567\xE2\x82") == "\"1234567" + r + '"');
+}
+
+namespace {
+    // A scope declaration N, with a variable v of type int, as the DOM would have it.
+    struct Tree {
+        Tree()
+        {
+            decl.id            = "decl.scope";
+            decl.props["name"] = "N";
+            decl.children      = {&scope};
+            // Each reference is drawn once, and only to a node in the graph.
+            decl.references.push_back(DeclIndex{DeclSort::Variable, 0});
+            decl.references.push_back(DeclIndex{DeclSort::Variable, 0});
+            decl.references.push_back(TypeIndex{TypeSort::Fundamental, 5});
+
+            scope.id               = "members";
+            scope.children         = {&variable};
+            variable.id            = R"(v "q")";
+            variable.props["name"] = R"(a<b>&c\d)";
+            variable.children      = {&type};
+            type.id                = "int";
+        }
+
+        util::Node decl{DeclIndex{DeclSort::Scope, 0}};
+        util::Node scope{ScopeIndex(1)};
+        util::Node variable{DeclIndex{DeclSort::Variable, 0}};
+        util::Node type{TypeIndex{TypeSort::Fundamental, 0}};
+    };
+
+    std::string graph(const util::Node& root, util::OutputFormat format, const util::GraphOptions& options = {})
+    {
+        std::string text;
+        {
+            util::OutputBuffer out{text};
+            util::GraphWriter writer{out, format, options};
+            writer.begin_file("a.ifc");
+            writer.write(root);
+            writer.end_records();
+            writer.end_file();
+            writer.finish();
+        }
+        return text;
+    }
+} // namespace
+
+TEST_CASE("DOT graphs escape the labels, and draw each edge once")
+{
+    const Tree tree;
+    CHECK(graph(tree.decl, util::OutputFormat::Dot) == R"(digraph "a.ifc" {
+  "decl.scope-0" [label="decl.scope\nN"];
+  "scope-1" [label="members"];
+  "decl.scope-0" -> "scope-1";
+  "decl.variable-0" [label="v \"q\"\na<b>&c\\d"];
+  "scope-1" -> "decl.variable-0";
+  "type.fundamental-0" [label="int"];
+  "decl.variable-0" -> "type.fundamental-0";
+  "decl.scope-0" -> "decl.variable-0" [style=dashed];
+}
+)");
+}
+
+TEST_CASE("GraphML documents escape the labels, and draw each edge once")
+{
+    const Tree tree;
+    CHECK(graph(tree.decl, util::OutputFormat::GraphML) == R"(<?xml version="1.0" encoding="UTF-8"?>
+<graphml xmlns="http://graphml.graphdrawing.org/xmlns">
+<key id="label" for="node" attr.name="label" attr.type="string"/>
+<key id="kind" for="node" attr.name="kind" attr.type="string"/>
+<key id="reference" for="edge" attr.name="reference" attr.type="boolean"/>
+<graph id="a.ifc" edgedefault="directed">
+<node id="decl.scope-0"><data key="kind">decl</data><data key="label">decl.scope&#10;N</data></node>
+<node id="scope-1"><data key="kind">scope</data><data key="label">members</data></node>
+<edge source="decl.scope-0" target="scope-1"/>
+<node id="decl.variable-0"><data key="kind">decl</data><data key="label">v &quot;q&quot;&#10;a&lt;b&gt;&amp;c\d</data></node>
+<edge source="scope-1" target="decl.variable-0"/>
+<node id="type.fundamental-0"><data key="kind">type</data><data key="label">int</data></node>
+<edge source="decl.variable-0" target="type.fundamental-0"/>
+<edge source="decl.scope-0" target="decl.variable-0"><data key="reference">true</data></edge>
+</graph>
+</graphml>
+)");
+
+    // Without any file, the document is still whole.
+    std::string text;
+    {
+        util::OutputBuffer out{text};
+        util::GraphWriter{out, util::OutputFormat::GraphML, {}}.finish();
+    }
+    CHECK(text == R"(<?xml version="1.0" encoding="UTF-8"?>
+<graphml xmlns="http://graphml.graphdrawing.org/xmlns">
+</graphml>
+)");
+}
+
+TEST_CASE("Nodes of the kinds left out of a graph pass their children to their nearest ancestor")
+{
+    const Tree tree;
+    util::GraphOptions options;
+    options.kinds = {util::SortKind::Decl};
+    CHECK(graph(tree.decl, util::OutputFormat::Dot, options) == R"(digraph "a.ifc" {
+  "decl.scope-0" [label="decl.scope\nN"];
+  "decl.variable-0" [label="v \"q\"\na<b>&c\\d"];
+  "decl.scope-0" -> "decl.variable-0";
+  "decl.scope-0" -> "decl.variable-0" [style=dashed];
+}
+)");
+}
+
+TEST_CASE("Scopes are clusters, closed when the node budget is spent")
+{
+    const Tree tree;
+    util::GraphOptions options;
+    options.cluster_scopes = true;
+    CHECK(graph(tree.decl, util::OutputFormat::GraphML, options) == R"(<?xml version="1.0" encoding="UTF-8"?>
+<graphml xmlns="http://graphml.graphdrawing.org/xmlns">
+<key id="label" for="node" attr.name="label" attr.type="string"/>
+<key id="kind" for="node" attr.name="kind" attr.type="string"/>
+<key id="reference" for="edge" attr.name="reference" attr.type="boolean"/>
+<graph id="a.ifc" edgedefault="directed">
+<node id="decl.scope-0"><data key="kind">decl</data><data key="label">decl.scope&#10;N</data></node>
+<node id="scope-1"><data key="kind">scope</data><data key="label">members</data>
+<graph id="scope-1:" edgedefault="directed">
+<edge source="decl.scope-0" target="scope-1"/>
+<node id="decl.variable-0"><data key="kind">decl</data><data key="label">v &quot;q&quot;&#10;a&lt;b&gt;&amp;c\d</data></node>
+<edge source="scope-1" target="decl.variable-0"/>
+<node id="type.fundamental-0"><data key="kind">type</data><data key="label">int</data></node>
+<edge source="decl.variable-0" target="type.fundamental-0"/>
+</graph></node>
+<edge source="decl.scope-0" target="decl.variable-0"><data key="reference">true</data></edge>
+</graph>
+</graphml>
+)");
+
+    options.node_budget = 3;
+    CHECK(graph(tree.decl, util::OutputFormat::Dot, options) == R"(digraph "a.ifc" {
+  "decl.scope-0" [label="decl.scope\nN"];
+subgraph "cluster_scope-1" {
+  "scope-1" [label="members"];
+  "decl.scope-0" -> "scope-1";
+  "decl.variable-0" [label="v \"q\"\na<b>&c\\d"];
+  "scope-1" -> "decl.variable-0";
+}
+  "decl.scope-0" -> "decl.variable-0" [style=dashed];
+}
+)");
+}
+
+TEST_CASE("A node reached from several parents is drawn once, with an edge from each")
+{
+    // f and g are members of the scope; the body of f declares g, which is reached there first.
+    util::Node scope{ScopeIndex(1)};
+    util::Node f{DeclIndex{DeclSort::Function, 0}};
+    util::Node g{DeclIndex{DeclSort::Function, 1}};
+    util::Node body{StmtIndex{StmtSort::Block, 0}};
+    util::Node type{TypeIndex{TypeSort::Function, 0}};
+    scope.id       = "members";
+    scope.children = {&f, &g};
+    f.id           = "f";
+    f.children     = {&body};
+    body.id        = "body";
+    body.children  = {&g};
+    g.id           = "g";
+    g.children     = {&type};
+    type.id        = "int(int)const";
+
+    CHECK(graph(scope, util::OutputFormat::Dot) == R"(digraph "a.ifc" {
+  "scope-1" [label="members"];
+  "decl.function-0" [label="f"];
+  "scope-1" -> "decl.function-0";
+  "stmt.block-0" [label="body"];
+  "decl.function-0" -> "stmt.block-0";
+  "decl.function-1" [label="g"];
+  "stmt.block-0" -> "decl.function-1";
+  "type.function-0" [label="int(int)const"];
+  "decl.function-1" -> "type.function-0";
+  "scope-1" -> "decl.function-1";
+}
+)");
+}
@@ -0,0 +1,305 @@
+// Copyright Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Small IFC files built in memory, for the tests that need an IFC of a given shape rather
+// than one produced by a compiler.
+
+#ifndef IFC_TEST_SYNTHETIC_H
+#define IFC_TEST_SYNTHETIC_H
+
+#include "ifc/abstract-sgraph.hxx"
+#include "ifc/file.hxx"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ifc::test {
+    // Lays out partitions, string table and table of contents as a compiler would.  Entries are
+    // appended to the partitions in the order they are made; trait entries must be made in the
+    // order of their entities.
+    class IfcBuilder {
+    public:
+        TextOffset text(std::string_view str)
+        {
+            const std::string delimited = std::string{str} + '\0';
+            for (auto pos = strings.find(delimited); pos != std::string::npos; pos = strings.find(delimited, pos + 1))
+                if (strings[pos - 1] == '\0')
+                    return TextOffset(static_cast<uint32_t>(pos));
+            const auto offset = TextOffset(static_cast<uint32_t>(strings.size()));
+            strings.append(delimited);
+            return offset;
+        }
+
+        NameIndex identifier(std::string_view str)
+        {
+            return {NameSort::Identifier, ifc::to_underlying(text(str))};
+        }
+
+        // Append the entry to the partition of that name; its position in the partition.
+        template<typename T>
+        uint32_t add(std::string_view partition, const T& entry)
+        {
+            auto& part       = partition_named(partition, sizeof(T));
+            const auto* data = reinterpret_cast<const std::byte*>(&entry);
+            part.bytes.insert(part.bytes.end(), data, data + sizeof(T));
+            return part.count++;
+        }
+
+        template<typename T>
+        TypeIndex type(const T& entry)
+        {
+            return {T::algebra_sort, add(sort_name(T::algebra_sort), entry)};
+        }
+
+        template<typename T>
+        ExprIndex expr(const T& entry)
+        {
+            return {T::algebra_sort, add(sort_name(T::algebra_sort), entry)};
+        }
+
+        template<typename T>
+        StmtIndex stmt(const T& entry)
+        {
+            return {T::algebra_sort, add(sort_name(T::algebra_sort), entry)};
+        }
+
+        template<typename T>
+        DeclIndex decl(const T& entry)
+        {
+            return {T::algebra_sort, add(sort_name(T::algebra_sort), entry)};
+        }
+
+        template<typename T>
+        void trait(const T& entry)
+        {
+            add(sort_name(T::partition_tag), entry);
+        }
+
+        // Append the items to the heap; their sequence in it.
+        template<typename T>
+        Sequence<T> heap(HeapSort sort, const std::vector<T>& items)
+        {
+            Sequence<T> seq{Index(partition_named(sort_name(sort), sizeof(T)).count),
+                            Cardinality(static_cast<uint32_t>(items.size()))};
+            for (const auto& item : items)
+                add(sort_name(sort), item);
+            return seq;
+        }
+
+        // The scope of the declarations, as the initializer of a scope declaration (or the global
+        // scope); the first scope is 1.
+        ScopeIndex scope(const std::vector<DeclIndex>& members)
+        {
+            symbolic::Scope desc{};
+            desc.start       = Index(partition_named("scope.member", sizeof(symbolic::Declaration)).count);
+            desc.cardinality = Cardinality(static_cast<uint32_t>(members.size()));
+            for (auto member : members)
+                add("scope.member", symbolic::Declaration{member});
+            return ScopeIndex(add("scope.desc", desc) + 1);
+        }
+
+        // The bytes of the IFC of the primary interface of that module, with its content hash.
+        std::vector<std::byte> finish(std::string_view module, ScopeIndex global_scope)
+        {
+            Header header{};
+            header.version      = CurrentFormatVersion;
+            header.unit         = UnitIndex(text(module), UnitSort::Primary);
+            header.src_path     = text(std::string{module} + ".ixx");
+            header.global_scope = global_scope;
+            std::vector<PartitionSummaryData> toc;
+            for (const auto& part : parts)
+                toc.push_back({text(part.name), {}, Cardinality(part.count), EntitySize(part.entry_size)});
+
+            std::vector<std::byte> bytes(sizeof InterfaceSignature + sizeof header);
+            auto align = [&] { bytes.resize((bytes.size() + 7) / 8 * 8); };
+            auto append = [&](const void* data, std::size_t size) {
+                const auto* first = static_cast<const std::byte*>(data);
+                bytes.insert(bytes.end(), first, first + size);
+            };
+            for (std::size_t i = 0; i < parts.size(); ++i)
+            {
+                align();
+                toc[i].offset = ByteOffset(static_cast<uint32_t>(bytes.size()));
+                append(parts[i].bytes.data(), parts[i].bytes.size());
+            }
+            header.string_table_bytes = ByteOffset(static_cast<uint32_t>(bytes.size()));
+            header.string_table_size  = Cardinality(static_cast<uint32_t>(strings.size()));
+            append(strings.data(), strings.size());
+            align();
+            header.toc             = ByteOffset(static_cast<uint32_t>(bytes.size()));
+            header.partition_count = Cardinality(static_cast<uint32_t>(toc.size()));
+            append(toc.data(), toc.size() * sizeof(PartitionSummaryData));
+
+            std::memcpy(bytes.data(), InterfaceSignature, sizeof InterfaceSignature);
+            std::memcpy(bytes.data() + sizeof InterfaceSignature, &header, sizeof header);
+            // The content hash covers everything after it.
+            const auto* hashed   = bytes.data() + sizeof InterfaceSignature + sizeof(SHA256Hash);
+            header.content_hash = hash_bytes(hashed, bytes.data() + bytes.size());
+            std::memcpy(bytes.data() + sizeof InterfaceSignature, &header, sizeof header);
+            return bytes;
+        }
+
+    private:
+        struct Partition {
+            std::string name;
+            uint32_t entry_size;
+            uint32_t count;
+            std::vector<std::byte> bytes;
+        };
+
+        Partition& partition_named(std::string_view name, std::size_t entry_size)
+        {
+            for (auto& part : parts)
+                if (part.name == name)
+                    return part;
+            return parts.emplace_back(std::string{name}, static_cast<uint32_t>(entry_size), 0u);
+        }
+
+        std::vector<Partition> parts;
+        std::string strings = std::string(1, '\0');
+    };
+
+    struct SampleOptions {
+        std::string module = "m";
+        uint32_t first_line = 1;        // line of the first declaration; the others follow
+        bool functions_swapped = false; // declare g before f
+    };
+
+    // The primary interface of a module with
+    //
+    //     export namespace N {
+    //         struct S { int x; S* next; }; // attached to the global module
+    //         const int deep = 1 + 1 + ...;
+    //     }
+    //     export int f(const int&) { g; }
+    //     export int g(const int&) { f; }
+    //
+    // where each function body declares the other function, so that their DOM nodes are a cycle.
+    inline std::vector<std::byte> sample_ifc(const SampleOptions& options = {})
+    {
+        using namespace symbolic;
+        IfcBuilder ifc;
+        uint32_t line = options.first_line;
+        auto locus    = [&] { return SourceLocation{LineIndex(line++), ColumnNumber(1)}; };
+
+        FundamentalType int_type{};
+        int_type.basis = TypeBasis::Int;
+        FundamentalType namespace_type{};
+        namespace_type.basis = TypeBasis::Namespace;
+        FundamentalType struct_type{};
+        struct_type.basis = TypeBasis::Struct;
+        const auto t_int  = ifc.type(int_type);
+        QualifiedType const_int{};
+        const_int.unqualified_type = t_int;
+        const_int.qualifiers       = Qualifier::Const;
+        const auto t_cint          = ifc.type(const_int);
+        LvalueReferenceType reference{};
+        reference.referee = t_cint;
+        FunctionType function{};
+        function.target       = t_int;
+        function.source       = ifc.type(reference);
+        const auto t_function = ifc.type(function);
+
+        // The scopes are made last: 1 is the global scope, 2 that of N, 3 that of S.
+        const DeclIndex n{DeclSort::Scope, 0};
+        const DeclIndex s{DeclSort::Scope, 1};
+        ScopeDecl n_decl{};
+        n_decl.identity    = {ifc.identifier("N"), locus()};
+        n_decl.type        = ifc.type(namespace_type);
+        n_decl.initializer = ScopeIndex(2);
+        n_decl.basic_spec  = BasicSpecifiers::External;
+        ifc.decl(n_decl);
+        ScopeDecl s_decl{};
+        s_decl.identity    = {ifc.identifier("S"), locus()};
+        s_decl.type        = ifc.type(struct_type);
+        s_decl.home_scope  = n;
+        s_decl.initializer = ScopeIndex(3);
+        s_decl.basic_spec  = BasicSpecifiers(ifc::to_underlying(BasicSpecifiers::External)
+                                             | ifc::to_underlying(BasicSpecifiers::IsMemberOfGlobalModule));
+        ifc.decl(s_decl);
+
+        std::vector<DeclIndex> s_members;
+        FieldDecl x{};
+        x.identity   = {ifc.text("x"), locus()};
+        x.type       = t_int;
+        x.home_scope = s;
+        x.access     = Access::Public;
+        s_members.push_back(ifc.decl(x));
+        FieldDecl next{};
+        next.identity   = {ifc.text("next"), locus()};
+        DesignatedType designated{};
+        designated.decl = s;
+        PointerType pointer{};
+        pointer.pointee = ifc.type(designated);
+        next.type       = ifc.type(pointer);
+        next.home_scope = s;
+        next.access     = Access::Public;
+        s_members.push_back(ifc.decl(next));
+
+        // f and g, in the order of the options; each body is a block declaring the other one.
+        const auto first  = ifc.identifier(options.functions_swapped ? "g" : "f");
+        const auto second = ifc.identifier(options.functions_swapped ? "f" : "g");
+        std::vector<DeclIndex> global_members{n};
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            const DeclIndex self{DeclSort::Function, i};
+            const DeclIndex other{DeclSort::Function, 1 - i};
+            FunctionDecl fn{};
+            fn.identity   = {i == 0 ? first : second, locus()};
+            fn.type       = t_function;
+            fn.basic_spec = BasicSpecifiers::External;
+            ifc.decl(fn);
+            global_members.push_back(self);
+
+            DeclStmt declaration{};
+            declaration.locus = locus();
+            declaration.decl  = other;
+            BlockStmt block{};
+            block.locus = locus();
+            static_cast<Sequence<StmtIndex, HeapSort::Stmt>&>(block) =
+                {ifc.heap(HeapSort::Stmt, std::vector{ifc.stmt(declaration)}).start, Cardinality(1)};
+            trait::MsvcCodegenMappingExpr body{};
+            body.entity     = self;
+            body.trait.body = ifc.stmt(block);
+            ifc.trait(body);
+        }
+
+        LiteralExpr one{};
+        one.type  = t_int;
+        one.value = LitIndex{LiteralSort::Immediate, 1};
+        ExprIndex sum = ifc.expr(one);
+        for (int i = 0; i < 8; ++i)
+        {
+            DyadicExpr plus{};
+            plus.type   = t_int;
+            plus.arg[0] = sum;
+            plus.arg[1] = ifc.expr(one);
+            plus.assort = DyadicOperator::Plus;
+            sum         = ifc.expr(plus);
+        }
+        VariableDecl deep{};
+        deep.identity    = {ifc.identifier("deep"), locus()};
+        deep.type        = t_cint;
+        deep.home_scope  = n;
+        deep.initializer = sum;
+        deep.basic_spec  = BasicSpecifiers::External;
+        const std::vector<DeclIndex> n_members{s, ifc.decl(deep)};
+
+        const auto global = ifc.scope(global_members);
+        ifc.scope(n_members);
+        ifc.scope(s_members);
+        return ifc.finish(options.module, global);
+    }
+
+    inline void write_file(const std::filesystem::path& path, const std::vector<std::byte>& bytes)
+    {
+        std::ofstream stream{path, std::ios_base::binary | std::ios_base::trunc};
+        stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+} // namespace ifc::test
+
+#endif // IFC_TEST_SYNTHETIC_H